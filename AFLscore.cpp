@@ -1,19 +1,10 @@
 #include "splashkit.h"
+#include "output_buffer.h"
+#include "terminal_ui.h"
+#include "number_parsing.h"
+#include "input_script.h"
 #include <string>
-#include <stdexcept>
-#include <cctype>
-#include <algorithm>
-
-/**
- * @brief Checks if a string contains only digits
- *
- * @param s The string to check
- * @return bool True if the string contains only digits, false otherwise
- */
-bool is_whole_number(const std::string &s)
-{
-    return !s.empty() && std::all_of(s.begin(), s.end(), ::isdigit);
-}
+#include <cstdlib>
 
 /**
  * @brief Reads a string input from the user
@@ -23,8 +14,7 @@ bool is_whole_number(const std::string &s)
  */
 std::string read_string(const std::string &prompt)
 {
-    write(prompt);
-    return read_line();
+    return read_input_line(prompt);
 }
 
 /**
@@ -35,31 +25,32 @@ std::string read_string(const std::string &prompt)
  */
 int read_integer(const std::string &prompt)
 {
-    std::string input;
-    bool valid_input = false;
     int number = 0;
+    bool valid_input = false;
 
     while (!valid_input)
     {
-        write(prompt);
-        input = read_line();
+        parse_status status = parse_int(read_input_line(prompt), number);
 
-        if (is_whole_number(input))
+        // Piped or replayed input can run out before a number turns up
+        if (status != PARSE_OK && input_ended())
         {
-            try
-            {
-                number = std::stoi(input);
-                valid_input = true;
-            }
-            catch (const std::out_of_range &)
-            {
-                write_line("Number out of range. Please enter a smaller number");
-            }
+            write_line("The input ended before a whole number was entered");
+            std::exit(1);
         }
-        else
+
+        if (status == PARSE_OUT_OF_RANGE)
+        {
+            write_line("Number out of range. Please enter a smaller number");
+        }
+        else if (status != PARSE_OK || number < 0)
         {
             write_line("Please enter a whole number");
         }
+        else
+        {
+            valid_input = true;
+        }
     }
 
     return number;
@@ -77,8 +68,7 @@ bool read_yes_no(const std::string &prompt)
 
     while (true)
     {
-        write(prompt);
-        input = read_line();
+        input = read_input_line(prompt);
 
         if (input == "y" || input == "Y")
         {
@@ -149,12 +139,14 @@ void output_details(const std::string &team1_name, int team1_goals, int team1_be
     int team1_score = calculate_score(team1_goals, team1_behinds);
     int team2_score = calculate_score(team2_goals, team2_behinds);
 
-    write_line("Calculating details...");
-    write_line(determine_winner(team1_name, team1_score, team2_name, team2_score));
-    write_line(team1_name + ": " + std::to_string(team1_goals) + ", " + std::to_string(team1_behinds) +
-               ", " + std::to_string(team1_score));
-    write_line(team2_name + ": " + std::to_string(team2_goals) + ", " + std::to_string(team2_behinds) +
-               ", " + std::to_string(team2_score));
+    output_buffer &out = console_output();
+    buffer_write_line(out, "Calculating details...");
+    buffer_write_line(out, determine_winner(team1_name, team1_score, team2_name, team2_score));
+    buffer_write_line(out, team1_name + ": " + std::to_string(team1_goals) + ", " + std::to_string(team1_behinds) +
+                               ", " + std::to_string(team1_score));
+    buffer_write_line(out, team2_name + ": " + std::to_string(team2_goals) + ", " + std::to_string(team2_behinds) +
+                               ", " + std::to_string(team2_score));
+    flush_output(out);
 }
 
 /**
@@ -217,22 +209,68 @@ void draw_scoreboard(const std::string &team1_name, int team1_goals, int team1_b
  */
 void print_menu(const std::string &team1_name, const std::string &team2_name)
 {
-    write_line("Menu:");
-    write_line("1: Update " + team1_name + " goals");
-    write_line("2: Update " + team1_name + " behinds");
-    write_line("3: Update " + team2_name + " goals");
-    write_line("4: Update " + team2_name + " behinds");
-    write_line("5: Print details");
-    write_line("6: Quit");
+    output_buffer &out = console_output();
+    buffer_write_line(out, "Menu:");
+    buffer_write_line(out, "1: Update " + team1_name + " goals");
+    buffer_write_line(out, "2: Update " + team1_name + " behinds");
+    buffer_write_line(out, "3: Update " + team2_name + " goals");
+    buffer_write_line(out, "4: Update " + team2_name + " behinds");
+    buffer_write_line(out, "5: Print details");
+    buffer_write_line(out, "6: Quit");
+    flush_output(out);
+}
+
+/**
+ * @brief Draws the scores and menu into a panel fixed at the top of the terminal,
+ * sending only the cells that changed since the last time
+ *
+ * @param screen The panel to draw into
+ * @param team1_name Name of the first team
+ * @param team1_goals Number of goals scored by the first team
+ * @param team1_behinds Number of behinds scored by the first team
+ * @param team2_name Name of the second team
+ * @param team2_goals Number of goals scored by the second team
+ * @param team2_behinds Number of behinds scored by the second team
+ */
+void display_score_panel(terminal_screen &screen, const std::string &team1_name, int team1_goals, int team1_behinds,
+                         const std::string &team2_name, int team2_goals, int team2_behinds)
+{
+    int team1_score = calculate_score(team1_goals, team1_behinds);
+    int team2_score = calculate_score(team2_goals, team2_behinds);
+
+    clear_screen_buffer(screen);
+    fill_row(screen, 0, STYLE_INVERSE);
+    put_text(screen, 1, 0, "AFL SCOREBOARD", STYLE_INVERSE | STYLE_BOLD);
+
+    put_text(screen, 1, 2, team1_name + ": " + std::to_string(team1_goals) + "." + std::to_string(team1_behinds) +
+                               " (" + std::to_string(team1_score) + ")");
+    put_text(screen, 1, 3, team2_name + ": " + std::to_string(team2_goals) + "." + std::to_string(team2_behinds) +
+                               " (" + std::to_string(team2_score) + ")");
+    put_text(screen, 1, 4, determine_winner(team1_name, team1_score, team2_name, team2_score), STYLE_BOLD);
+
+    put_text(screen, 1, 6, "1: Update " + team1_name + " goals");
+    put_text(screen, 1, 7, "2: Update " + team1_name + " behinds");
+    put_text(screen, 1, 8, "3: Update " + team2_name + " goals");
+    put_text(screen, 1, 9, "4: Update " + team2_name + " behinds");
+    put_text(screen, 1, 10, "5: Print details");
+    put_text(screen, 1, 11, "6: Quit");
+    put_text(screen, 0, 12, std::string(screen.width, '-'));
+    present_screen(screen);
 }
 
 /**
  * @brief Main program entry point
  *
+ * @param argc Number of command line arguments
+ * @param argv Command line arguments, --tui keeps the scores and menu on screen,
+ *             --record/--replay <file> save or play back the input
  * @return int Program exit code
  */
-int main()
+int main(int argc, char *argv[])
 {
+    argc = use_input_script(argc, argv);
+    bool use_tui = argc > 1 && std::string(argv[1]) == "--tui";
+    terminal_screen screen;
     std::string team1_name, team2_name;
     int team1_goals, team1_behinds, team2_goals, team2_behinds;
     int option;
@@ -255,14 +293,28 @@ int main()
     team2_behinds = read_integer("behinds: ");
 
     // Initial output of details
-    output_details(team1_name, team1_goals, team1_behinds, team2_name, team2_goals, team2_behinds);
+    if (use_tui)
+    {
+        open_terminal_screen(screen, 60, 13);
+    }
+    else
+    {
+        output_details(team1_name, team1_goals, team1_behinds, team2_name, team2_goals, team2_behinds);
+    }
 
     // Draw initial scoreboard
     draw_scoreboard(team1_name, team1_goals, team1_behinds, team2_name, team2_goals, team2_behinds);
 
     while (running)
     {
-        print_menu(team1_name, team2_name);
+        if (use_tui)
+        {
+            display_score_panel(screen, team1_name, team1_goals, team1_behinds, team2_name, team2_goals, team2_behinds);
+        }
+        else
+        {
+            print_menu(team1_name, team2_name);
+        }
 
         process_events();
 
@@ -296,12 +348,17 @@ int main()
             team2_behinds = read_integer("behinds: ");
             break;
         case 5:
-            output_details(team1_name, team1_goals, team1_behinds, team2_name, team2_goals, team2_behinds);
+            // The panel already shows the details
+            if (!use_tui)
+            {
+                output_details(team1_name, team1_goals, team1_behinds, team2_name, team2_goals, team2_behinds);
+            }
             break;
         case 6:
             if (read_yes_no("Are you sure you want to quit? [Y/n]: "))
             {
                 running = false;
+                close_terminal_screen(screen);
                 write_line("Bye!");
                 delay(1000);
                 close_window("AFL Score Calculator");
@@ -5,91 +5,127 @@
  * using mouse clicks and keyboard controls.
  */
 #include "splashkit.h"
+#include "frame_profiler.h"
 
-int main()
+int main(int argc, char *argv[])
 {
     // Create and open a window with specified title and dimensions
     window window = open_window("Interactive Circles", 800, 600);
 
+    // Profile each frame; F1 shows the HUD, --profile-csv <file> saves the timings
+    frame_profiler profiler;
+    if (argc == 3 && string(argv[1]) == "--profile-csv")
+    {
+        start_profile_csv(profiler, argv[2]);
+    }
+
     // Initialize variables
     int current_radius = 50;
     color background_color;
     bool quit_program = false;
 
+    // Circles are drawn on a canvas bitmap that is copied to the window each
+    // frame, so the profiler HUD can be drawn over it without erasing them
+    bitmap canvas = create_bitmap("canvas", window_width(window), window_height(window));
+
     // Set initial background to white
-    clear_screen(COLOR_WHITE);
+    clear_bitmap(canvas, COLOR_WHITE);
 
     // Main program loop
     // Continues until window is closed or quit is requested
     while (!window_close_requested(window) && !quit_program)
     {
-        // Handle any pending events (keyboard, mouse, etc.)
-        process_events();
+        begin_profile_frame(profiler);
 
-        // Handle keyboard inputs
-        if (key_typed(C_KEY))
-        {
-            // Change background color to a random color
-            background_color = random_rgb_color(255);
-            clear_screen(background_color);
-        }
-        else if (key_typed(S_KEY))
-        {
-            // Set circle size to small
-            current_radius = 10;
-        }
-        else if (key_typed(M_KEY))
+        // Handle any pending events (keyboard, mouse, etc.)
         {
-            // Set circle size to medium
-            current_radius = 50;
+            profile_scope input_zone(profile_zones(profiler), PROFILE_INPUT);
+            process_events();
         }
-        else if (key_typed(L_KEY))
+
+        // Show or hide the profiler HUD (it draws over the canvas)
+        if (key_typed(F1_KEY))
         {
-            // Set circle size to large
-            current_radius = 100;
+            toggle_profiler_hud(profiler);
         }
-        else if (key_typed(NUM_5_KEY))
+
+        // Keys and clicks draw onto the canvas, so handling them is timed as drawing
         {
-            // Generate 100 random circles across the window
-            for (int i = 0; i < 100; i++)
+            profile_scope draw_zone(profile_zones(profiler), PROFILE_DRAW);
+
+            // Handle keyboard inputs
+            if (key_typed(C_KEY))
+            {
+                // Change background color to a random color
+                background_color = random_rgb_color(255);
+                clear_bitmap(canvas, background_color);
+            }
+            else if (key_typed(S_KEY))
+            {
+                // Set circle size to small
+                current_radius = 10;
+            }
+            else if (key_typed(M_KEY))
             {
-                // Generate random position within window bounds
-                double x = rnd(window_width(window));
-                double y = rnd(window_height(window));
+                // Set circle size to medium
+                current_radius = 50;
+            }
+            else if (key_typed(L_KEY))
+            {
+                // Set circle size to large
+                current_radius = 100;
+            }
+            else if (key_typed(NUM_5_KEY))
+            {
+                // Generate 100 random circles across the window
+                for (int i = 0; i < 100; i++)
+                {
+                    // Generate random position within window bounds
+                    double x = rnd(window_width(window));
+                    double y = rnd(window_height(window));
 
-                // Create random color and size
-                color random_color = random_rgb_color(255);
-                int random_radius = rnd(10, 100);
+                    // Create random color and size
+                    color random_color = random_rgb_color(255);
+                    int random_radius = rnd(10, 100);
 
-                // Draw the circle
-                fill_circle(random_color, x, y, random_radius);
+                    // Draw the circle
+                    fill_circle_on_bitmap(canvas, random_color, x, y, random_radius);
+                }
+            }
+            else if (key_typed(Q_KEY))
+            {
+                // Set flag to quit the program
+                quit_program = true;
             }
-        }
-        else if (key_typed(Q_KEY))
-        {
-            // Set flag to quit the program
-            quit_program = true;
-        }
 
-        // Handle mouse input
-        if (mouse_clicked(LEFT_BUTTON))
-        {
-            // Get current mouse position
-            double x_pos = mouse_x();
-            double y_pos = mouse_y();
+            // Handle mouse input
+            if (mouse_clicked(LEFT_BUTTON))
+            {
+                // Get current mouse position
+                double x_pos = mouse_x();
+                double y_pos = mouse_y();
 
-            // Generate a random color
-            color random_color = random_rgb_color(255);
+                // Generate a random color
+                color random_color = random_rgb_color(255);
+
+                // Draw a filled circle at mouse position with current radius setting
+                fill_circle_on_bitmap(canvas, random_color, x_pos, y_pos, current_radius);
+            }
 
-            // Draw a filled circle at mouse position with current radius setting
-            fill_circle(random_color, x_pos, y_pos, current_radius);
+            // Copy the canvas to the window, covering last frame's HUD
+            draw_bitmap(canvas, 0, 0);
         }
 
+        // Draw the profiler HUD, then finish timing the frame
+        draw_profiler_hud(profiler, 530, 10);
+        end_profile_frame(profiler);
+
         // Update the screen at 60 frames per second
         refresh_screen(60);
     }
 
-    // Clean up resources by closing the window
+    // Clean up resources by freeing the canvas and closing the window
+    free_bitmap(canvas);
     close_window(window);
     return 0;
 }
\ No newline at end of file
@@ -1,12 +1,37 @@
 #include "splashkit.h"
+#include "output_buffer.h"
+#include "number_parsing.h"
+#include "input_script.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
 
 /**
  * Print text to the terminal a number of times, allowing repeated patterns.
+ * The copies are built up in the console buffer rather than written one by one.
  * @param text The text to print
  * @param count The number of times to print the text
  * @param new_line Should a new line be printed after the text?
  */
 void print_repeated(string text, int count, bool new_line)
+{
+    output_buffer &out = console_output();
+    buffer_repeat(out, text, count > 0 ? count : 0);
+
+    if (new_line)
+    {
+        buffer_write_line(out, "\n");
+    }
+}
+
+/**
+ * Print text a number of times with one write per repetition, the way
+ * print_repeated used to. Kept to compare against in the benchmark.
+ * @param text The text to print
+ * @param count The number of times to print the text
+ * @param new_line Should a new line be printed after the text?
+ */
+void print_repeated_direct(string text, int count, bool new_line)
 {
     for (int i = 0; i < count; i++)
     {
@@ -28,22 +53,73 @@ void print_line(int length)
     print_repeated("-", length, true);
 }
 
-int main()
+/**
+ * Time printing lines with and without the console buffer. Redirect the
+ * output (e.g. to /dev/null) to time the program rather than the terminal;
+ * the results go to standard error.
+ * @param lines The number of lines to print each way
+ * @param length The length of each line
+ */
+void benchmark_print_line(int lines, int length)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < lines; i++)
+    {
+        print_repeated_direct("-", length, true);
+    }
+    double direct_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < lines; i++)
+    {
+        print_line(length);
+    }
+    flush_output(console_output());
+    double buffered_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::cerr << "Direct:   " << lines / direct_seconds << " lines/s" << std::endl;
+    std::cerr << "Buffered: " << lines / buffered_seconds << " lines/s" << std::endl;
+}
+
+int main(int argc, char *argv[])
 {
     string input;
     int test_length;
 
+    // PrintLine --benchmark <lines> [length]
+    // PrintLine --record <file> | --replay <file>
+    argc = use_input_script(argc, argv);
+    if (argc >= 3 && string(argv[1]) == "--benchmark")
+    {
+        benchmark_print_line(std::atoi(argv[2]), argc >= 4 ? std::atoi(argv[3]) : 80);
+        return 0;
+    }
+
+    output_buffer &out = console_output();
+
     print_line(20);
-    write_line("| Line print test  |");
+    buffer_write_line(out, "| Line print test  |");
     print_line(20);
 
     print_repeated("--+--+", 5, true);
     print_repeated("Hello World\n", 5, false);
     print_repeated("--+--+", 5, true);
 
-    write("Enter a length for a test line: ");
-    input = read_line();
-    test_length = stoi(input);
+    flush_output(out);
+    input = read_input_line("Enter a length for a test line: ");
+    parse_status status = parse_int(input, test_length);
+    while (status != PARSE_OK || test_length < 0)
+    {
+        // Piped or replayed input can run out before a valid length turns up
+        if (input_ended())
+        {
+            write_line("The input ended before a valid length was entered");
+            return 1;
+        }
+        write_line(status == PARSE_OK ? "The length cannot be negative" : parse_status_message(status));
+        input = read_input_line("Enter a length for a test line: ");
+        status = parse_int(input, test_length);
+    }
 
     print_line(test_length);
-}
\ No newline at end of file
+}
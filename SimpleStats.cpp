@@ -1,83 +1,898 @@
 #include "splashkit.h"
+#include "stats_summary.h"
+#include "stats_window.h"
+#include "stats_groups.h"
+#include "stats_sketches.h"
+#include "output_buffer.h"
+#include "number_parsing.h"
+#include "input_script.h"
 #include <string>
-#include <limits>
+#include <vector>
 #include <cctype>
 #include <algorithm>
-#include <stdexcept>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <chrono>
+#include <thread>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
-int main()
+// Resolution of the last T seconds window: it slides in steps of T / WINDOW_BUCKETS
+const int WINDOW_BUCKETS = 60;
+
+/**
+ * Distinct count and frequency sketches, kept only when asked for
+ *
+ * @field enabled  Whether values are added to the sketches
+ * @field distinct HyperLogLog count of distinct values
+ * @field counts   Count-Min estimates of how often each value came up
+ * @field top      Space-Saving list of the most frequent values
+ */
+struct value_sketches
 {
-    int count = 0;
-    double total = 0.0;
-    double min = std::numeric_limits<double>::max();
-    double max = std::numeric_limits<double>::lowest();
-    double average;
-    bool continue_input = true;
-    std::string answer;
-    std::string user_input;
-    bool valid_input;
+    bool enabled = false;
+    distinct_counter distinct;
+    count_min_sketch counts;
+    top_values top;
+};
 
-    write_line("Welcome to the simple stats calculator:");
+/**
+ * Statistics for one chunk of a file
+ *
+ * @field summary   Statistics of the values in the chunk
+ * @field sketches  Sketches of the values in the chunk
+ * @field malformed Lines that were not a number
+ */
+struct chunk_result
+{
+    stats_summary summary;
+    value_sketches sketches;
+    uint64_t malformed = 0;
+};
 
-    while (continue_input)
+/**
+ * Sets up the sketches with the error bounds asked for
+ *
+ * @param sketches        The sketches
+ * @param distinct_error  Relative error of the distinct count
+ * @param frequency_error How far frequencies may be over, as a fraction of all values
+ * @param confidence      Probability the Count-Min estimates are within their error
+ */
+void init_value_sketches(value_sketches &sketches, double distinct_error, double frequency_error, double confidence)
+{
+    sketches.enabled = true;
+    init_distinct_counter(sketches.distinct, distinct_error);
+    init_count_min(sketches.counts, frequency_error, confidence);
+    init_top_values(sketches.top, frequency_error);
+}
+
+/**
+ * Adds a value to every sketch, if they are enabled
+ *
+ * @param sketches The sketches
+ * @param value    The value to add
+ */
+void add_to_sketches(value_sketches &sketches, double value)
+{
+    if (!sketches.enabled)
+        return;
+
+    distinct_add(sketches.distinct, value);
+    count_min_add(sketches.counts, value);
+    top_add(sketches.top, value);
+}
+
+/**
+ * Merges one set of sketches into another set with the same bounds
+ *
+ * @param sketches The sketches to merge into
+ * @param other    The sketches to merge from
+ */
+void merge_sketches(value_sketches &sketches, const value_sketches &other)
+{
+    if (!sketches.enabled || !other.enabled)
+        return;
+
+    distinct_merge(sketches.distinct, other.distinct);
+    count_min_merge(sketches.counts, other.counts);
+    top_merge(sketches.top, other.top);
+}
+
+/**
+ * Prints the distinct count and the most frequent values
+ *
+ * @param sketches  The sketches
+ * @param top_count How many frequent values to list
+ */
+void print_sketches(const value_sketches &sketches, size_t top_count)
+{
+    if (!sketches.enabled)
+        return;
+
+    write_line("Distinct values: about " + std::to_string(static_cast<uint64_t>(std::llround(distinct_estimate(sketches.distinct)))));
+    write_line("Most frequent (value: count, Count-Min estimate):");
+    for (const frequent_value &entry : top_list(sketches.top, top_count))
+    {
+        double value = key_value(entry.key);
+        write_line("  " + std::to_string(value) + ": " + std::to_string(entry.count - entry.error) + " to " +
+                   std::to_string(entry.count) + ", " + std::to_string(count_min_estimate(sketches.counts, value)));
+    }
+}
+
+/**
+ * Moves both ends of some text inward past any blanks (including the \r of
+ * Windows line endings)
+ *
+ * @param first Start of the text
+ * @param last  End of the text
+ */
+void trim_blanks(const char *&first, const char *&last)
+{
+    while (first < last && std::isspace(static_cast<unsigned char>(*first)))
+        first++;
+    while (last > first && std::isspace(static_cast<unsigned char>(last[-1])))
+        last--;
+}
+
+/**
+ * Parses every line of a chunk of text, one number per line. Blank lines
+ * are skipped; anything else that is not a number is counted as malformed.
+ *
+ * @param begin  Start of the chunk, at the start of a line
+ * @param end    End of the chunk, just after a newline or at the end of the file
+ * @param result Receives the statistics for the chunk
+ */
+void summarize_chunk(const char *begin, const char *end, chunk_result &result)
+{
+    const char *line = begin;
+    while (line < end)
+    {
+        const char *line_end = static_cast<const char *>(std::memchr(line, '\n', end - line));
+        if (!line_end)
+            line_end = end;
+
+        double value;
+        parse_status status = parse_double(line, line_end, value);
+        if (status == PARSE_OK)
+        {
+            add_value(result.summary, value);
+            add_to_sketches(result.sketches, value);
+        }
+        else if (status != PARSE_EMPTY)
+        {
+            result.malformed++;
+        }
+
+        line = line_end + 1;
+    }
+}
+
+/**
+ * Memory maps a whole file for reading
+ *
+ * @param path The file to map
+ * @param data Receives the file's contents, nullptr if it is empty
+ * @param size Receives the file's size
+ * @return     True if the file could be mapped
+ */
+bool map_file(const std::string &path, const char *&data, size_t &size)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        write_line("Could not open " + path);
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0)
     {
-        write("Enter value: ");
-        user_input = read_line();
+        close(fd);
+        write_line("Could not read " + path);
+        return false;
+    }
 
-        try
+    size = static_cast<size_t>(info.st_size);
+    data = nullptr;
+    if (size > 0)
+    {
+        void *mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapping == MAP_FAILED)
         {
-            double value = std::stod(user_input);
-            valid_input = true;
+            close(fd);
+            write_line("Could not map " + path);
+            return false;
+        }
+        madvise(mapping, size, MADV_SEQUENTIAL);
+        data = static_cast<const char *>(mapping);
+    }
+
+    // The mapping stays valid once the file is closed
+    close(fd);
+    return true;
+}
+
+/**
+ * Releases a file mapped with map_file
+ *
+ * @param data The file's contents
+ * @param size The file's size
+ */
+void unmap_file(const char *data, size_t size)
+{
+    if (data)
+    {
+        munmap(const_cast<char *>(data), size);
+    }
+}
+
+/**
+ * Summarizes a file of numbers, one per line. The file is memory mapped
+ * and split into chunks at line boundaries, one chunk per thread, and the
+ * chunk results are merged.
+ *
+ * @param path     The file to read
+ * @param threads  How many threads to use
+ * @param summary  Receives the statistics of the file
+ * @param sketches Sketches set up with the bounds wanted, receives the file's values
+ * @return         True if the file could be read
+ */
+bool summarize_file(const std::string &path, int threads, stats_summary &summary, value_sketches &sketches)
+{
+    const char *data;
+    size_t size;
+    if (!map_file(path, data, size))
+        return false;
+
+    auto start = std::chrono::steady_clock::now();
+
+    // Split into roughly equal chunks, moving each split to just after a newline
+    threads = std::max(1, threads);
+    std::vector<const char *> splits;
+    splits.push_back(data);
+    for (int i = 1; i < threads; i++)
+    {
+        const char *split = std::max(data + size * i / threads, splits.back());
+        const char *newline = split < data + size ? static_cast<const char *>(std::memchr(split, '\n', data + size - split)) : nullptr;
+        splits.push_back(newline ? newline + 1 : data + size);
+    }
+    splits.push_back(data + size);
+
+    std::vector<chunk_result> results(threads);
+    std::vector<std::thread> workers;
+    for (int i = 0; i < threads; i++)
+    {
+        results[i].sketches = sketches;
+        workers.emplace_back(summarize_chunk, splits[i], splits[i + 1], std::ref(results[i]));
+    }
+
+    std::vector<stats_summary> summaries;
+    uint64_t malformed = 0;
+    for (int i = 0; i < threads; i++)
+    {
+        workers[i].join();
+        summaries.push_back(std::move(results[i].summary));
+        malformed += results[i].malformed;
+        if (i == 0)
+            sketches = std::move(results[0].sketches);
+        else
+            merge_sketches(sketches, results[i].sketches);
+    }
+    reduce_summaries(summaries);
+    summary = std::move(summaries[0]);
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    unmap_file(data, size);
+
+    write_line("Malformed lines: " + std::to_string(malformed));
+    std::string read = "Read " + std::to_string(size / 1e9) + " GB in " + std::to_string(seconds) + " s with " +
+                       std::to_string(threads) + " threads";
+    // An empty file can finish within one tick of the clock, and has no rate to speak of
+    if (size > 0 && seconds > 0)
+    {
+        read += ": " + std::to_string(size / 1e9 / seconds) + " GB/s";
+    }
+    write_line(read);
+    return true;
+}
+
+/**
+ * Combines summaries saved by earlier runs, without the data they came from
+ *
+ * @param paths   The saved summaries
+ * @param summary Receives the combined statistics
+ * @return        True if every file could be loaded
+ */
+bool merge_summary_files(const std::vector<std::string> &paths, stats_summary &summary)
+{
+    std::vector<stats_summary> summaries(paths.size());
+    for (size_t i = 0; i < paths.size(); i++)
+    {
+        if (!load_summary(summaries[i], paths[i]))
+        {
+            write_line("Could not load summary " + paths[i]);
+            return false;
+        }
+        if (summaries[i].sketch.k != summaries[0].sketch.k)
+        {
+            write_line("Could not merge summary " + paths[i] + ": its quantile sketch has k = " +
+                       std::to_string(summaries[i].sketch.k) + ", but " + paths[0] + " has k = " +
+                       std::to_string(summaries[0].sketch.k));
+            return false;
+        }
+    }
+
+    reduce_summaries(summaries);
+    summary = std::move(summaries[0]);
+    return true;
+}
+
+/**
+ * Times an update of each sketch on a set of values and prints the results
+ *
+ * @param label           What the values are, printed before the timings
+ * @param values          The values to add
+ * @param distinct_error  Relative error of the distinct count
+ * @param frequency_error How far frequencies may be over, as a fraction of all values
+ * @param confidence      Probability the Count-Min estimates are within their error
+ */
+void time_sketches(const std::string &label, const std::vector<double> &values,
+                   double distinct_error, double frequency_error, double confidence)
+{
+    value_sketches sketches;
+    init_value_sketches(sketches, distinct_error, frequency_error, confidence);
+
+    auto time_per_value = [&values](auto add)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (double value : values)
+        {
+            add(value);
+        }
+        return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / values.size();
+    };
+
+    double distinct_ns = time_per_value([&sketches](double value)
+                                        { distinct_add(sketches.distinct, value); });
+    double count_min_ns = time_per_value([&sketches](double value)
+                                         { count_min_add(sketches.counts, value); });
+    double top_ns = time_per_value([&sketches](double value)
+                                   { top_add(sketches.top, value); });
+
+    write_line(label + ":");
+    write_line("HyperLogLog: " + std::to_string(distinct_ns) + " ns/value, " +
+               std::to_string(sketches.distinct.registers.size()) + " registers");
+    write_line("Count-Min: " + std::to_string(count_min_ns) + " ns/value, " +
+               std::to_string(sketches.counts.depth) + " x " + std::to_string(sketches.counts.width) + " counters");
+    write_line("Space-Saving: " + std::to_string(top_ns) + " ns/value, " +
+               std::to_string(sketches.top.capacity) + " values tracked");
+    print_sketches(sketches, 5);
+}
+
+/**
+ * Times an update of each sketch on two sets of generated values: heavily
+ * skewed ones, the way repeated readings and a long tail of rare ones look
+ * in practice, and uniform ones that are nearly all distinct. The second is
+ * the worst case for Space-Saving, as almost every value evicts a tracked one.
+ *
+ * @param count           How many values to time each sketch on
+ * @param distinct_error  Relative error of the distinct count
+ * @param frequency_error How far frequencies may be over, as a fraction of all values
+ * @param confidence      Probability the Count-Min estimates are within their error
+ */
+void benchmark_sketches(size_t count, double distinct_error, double frequency_error, double confidence)
+{
+    std::vector<double> skewed(count);
+    std::vector<double> uniform(count);
+    uint64_t state = 0x9E3779B97F4A7C15ull;
+    for (size_t i = 0; i < count; i++)
+    {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        double fraction = ((state >> 11) + 1) * 0x1.0p-53;
+        skewed[i] = std::floor(std::pow(fraction, -1.2));
+        uniform[i] = std::floor(fraction * 1e9);
+    }
+
+    time_sketches("Skewed values", skewed, distinct_error, frequency_error, confidence);
+    write_line();
+    time_sketches("Uniform values (nearly all distinct)", uniform, distinct_error, frequency_error, confidence);
+}
+
+/**
+ * Splits every field off one line of CSV. A field in double quotes may
+ * hold commas; the quotes themselves are dropped.
+ *
+ * @param line     Start of the line
+ * @param line_end End of the line, without its newline
+ * @param fields   Receives the start and end of each field, trimmed
+ */
+void split_csv_line(const char *line, const char *line_end, std::vector<std::pair<const char *, const char *>> &fields)
+{
+    fields.clear();
+    const char *cursor = line;
+    while (true)
+    {
+        const char *first = cursor;
+        const char *last = line_end;
+        const char *comma;
+        trim_blanks(first, last);
+
+        if (first < line_end && *first == '"')
+        {
+            // Doubled quotes inside the field are skipped over here, and unescaped by the caller if needed
+            const char *close = first + 1;
+            while (close < line_end && !(*close == '"' && (close + 1 == line_end || close[1] != '"')))
+                close += *close == '"' ? 2 : 1;
+            first++;
+            last = std::min(close, line_end);
+            comma = close < line_end ? static_cast<const char *>(std::memchr(close, ',', line_end - close)) : nullptr;
+        }
+        else
+        {
+            comma = static_cast<const char *>(std::memchr(cursor, ',', line_end - cursor));
+            first = cursor;
+            last = comma ? comma : line_end;
+            trim_blanks(first, last);
+        }
+
+        fields.push_back({first, last});
+        if (!comma)
+            break;
+        cursor = comma + 1;
+    }
+}
+
+/**
+ * Summarizes every numeric column of a CSV file per group, in one pass.
+ * The first line names the columns; one of them holds the group keys and
+ * the others are numeric. Empty cells are skipped.
+ *
+ * @param path          The CSV file to read
+ * @param key_column    The name of the key column
+ * @param memory_budget Bytes the groups may take up
+ * @param table         Receives the statistics per group
+ * @param names         Receives the names of the numeric columns
+ * @return              True if the file could be read and had the key column
+ */
+bool summarize_groups(const std::string &path, const std::string &key_column, size_t memory_budget,
+                      group_table &table, std::vector<std::string> &names)
+{
+    const char *data;
+    size_t size;
+    if (!map_file(path, data, size))
+        return false;
+
+    auto start = std::chrono::steady_clock::now();
+    const char *end = data + size;
+    std::vector<std::pair<const char *, const char *>> fields;
+
+    // The header picks out the key column, every other column is numeric
+    const char *header_end = data ? static_cast<const char *>(std::memchr(data, '\n', size)) : nullptr;
+    if (!header_end)
+        header_end = end;
+    fields.clear();
+    if (data)
+        split_csv_line(data, header_end, fields);
+
+    int key_field = -1;
+    std::vector<int> column_of_field(fields.size(), -1);
+    names.clear();
+    for (size_t i = 0; i < fields.size(); i++)
+    {
+        std::string name(fields[i].first, fields[i].second);
+        if (name == key_column && key_field < 0)
+        {
+            key_field = static_cast<int>(i);
+        }
+        else
+        {
+            column_of_field[i] = static_cast<int>(names.size());
+            names.push_back(name);
+        }
+    }
+    if (key_field < 0)
+    {
+        unmap_file(data, size);
+        write_line("No column named " + key_column + " in " + path);
+        return false;
+    }
+
+    init_group_table(table, names.size(), memory_budget);
+    uint64_t rows = 0;
+    uint64_t malformed = 0;
+    std::string unescaped_key;
 
-            count++;
-            total += value;
+    const char *line = header_end < end ? header_end + 1 : end;
+    while (line < end)
+    {
+        const char *line_end = static_cast<const char *>(std::memchr(line, '\n', end - line));
+        const char *next = line_end ? line_end + 1 : end;
+        if (!line_end)
+            line_end = end;
+        if (line_end > line && line_end[-1] == '\r')
+            line_end--;
 
-            if (value < min)
+        if (line_end > line)
+        {
+            split_csv_line(line, line_end, fields);
+            if (fields.size() <= static_cast<size_t>(key_field))
             {
-                min = value;
+                malformed++;
             }
+            else
+            {
+                rows++;
+                // A quoted key may hold doubled quotes, each stands for one quote in the key
+                const char *key = fields[key_field].first;
+                size_t key_length = fields[key_field].second - key;
+                if (std::memchr(key, '"', key_length))
+                {
+                    unescaped_key.clear();
+                    for (size_t i = 0; i < key_length; i++)
+                    {
+                        unescaped_key += key[i];
+                        if (key[i] == '"' && i + 1 < key_length && key[i + 1] == '"')
+                            i++;
+                    }
+                    key = unescaped_key.data();
+                    key_length = unescaped_key.size();
+                }
+                uint32_t group = find_group(table, key, key_length);
+                prefetch_group(table, group);
+
+                size_t count = std::min(fields.size(), column_of_field.size());
+                for (size_t i = 0; i < count; i++)
+                {
+                    double value;
+                    if (column_of_field[i] < 0 || fields[i].first == fields[i].second)
+                        continue;
+                    if (parse_double(fields[i].first, fields[i].second, value) == PARSE_OK)
+                        add_group_value(table, group, column_of_field[i], value);
+                    else
+                        malformed++;
+                }
+            }
+        }
 
-            if (value > max)
+        line = next;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    unmap_file(data, size);
+
+    write_line("Rows: " + std::to_string(rows) + ", groups: " + std::to_string(group_count(table)) +
+               ", malformed cells: " + std::to_string(malformed));
+    if (table.folded_rows > 0)
+    {
+        write_line("Memory budget reached: " + std::to_string(table.folded_rows) + " rows of new keys counted as " + OTHER_GROUP_KEY);
+    }
+    std::string read = "Read " + std::to_string(size / 1e9) + " GB in " + std::to_string(seconds) + " s: ";
+    // As in summarize_file, a file too small to time has no rate
+    if (rows > 0 && seconds > 0)
+    {
+        read += std::to_string(rows / seconds / 1e6) + " million rows/s, ";
+    }
+    write_line(read + std::to_string(table.memory_used >> 20) + " MB of groups");
+    return true;
+}
+
+/**
+ * Prints the statistics of every group and column as CSV, ordered by key
+ *
+ * @param table The statistics per group
+ * @param names The names of the numeric columns
+ */
+void print_groups(const group_table &table, const std::vector<std::string> &names)
+{
+    std::vector<uint32_t> order(group_count(table));
+    for (uint32_t group = 0; group < order.size(); group++)
+    {
+        order[group] = group;
+    }
+    std::sort(order.begin(), order.end(), [&table](uint32_t a, uint32_t b)
+              { return table.key_bytes.compare(table.keys[a].start, table.keys[a].length, table.key_bytes,
+                                               table.keys[b].start, table.keys[b].length) < 0; });
+
+    // One line per group and column can be millions of lines, so they go through the buffer
+    output_buffer &out = console_output();
+    buffer_write_line(out, "key,column,count,total,min,max,average");
+    for (uint32_t group : order)
+    {
+        // Keys holding a comma, quote or line break are quoted, with their quotes doubled
+        std::string key = group_key(table, group);
+        if (key.find_first_of(",\"\r\n") != std::string::npos)
+        {
+            std::string quoted = "\"";
+            for (char c : key)
             {
-                max = value;
+                quoted += c;
+                if (c == '"')
+                    quoted += '"';
             }
+            key = quoted + "\"";
+        }
+        for (size_t column = 0; column < names.size(); column++)
+        {
+            const column_stats &stats = table.columns[column][group];
+            if (stats.count == 0)
+                continue;
+
+            buffer_write_line(out, key + "," + names[column] + "," + std::to_string(stats.count) + "," +
+                                       std::to_string(stats.total) + "," + std::to_string(stats.min) + "," +
+                                       std::to_string(stats.max) + "," + std::to_string(stats.total / stats.count));
+        }
+    }
+    flush_output(out);
+}
+
+/**
+ * Prints one line of windowed statistics
+ *
+ * @param label   What the window covers
+ * @param moments Statistics of the values in the window
+ */
+void print_moments(const std::string &label, const window_moments &moments)
+{
+    if (moments.count == 0)
+    {
+        write_line(label + ": no values");
+        return;
+    }
 
-            average = total / count;
+    write_line(label + ": count " + std::to_string(moments.count) +
+               ", min " + std::to_string(moments.min) +
+               ", max " + std::to_string(moments.max) +
+               ", average " + std::to_string(moments.mean) +
+               ", std dev " + std::to_string(std::sqrt(moments_variance(moments))));
+}
 
-            write_line("Count: " + std::to_string(count));
-            write_line("Total: " + std::to_string(total));
-            write_line("Min: " + std::to_string(min));
-            write_line("Max: " + std::to_string(max));
-            write_line("Average: " + std::to_string(average));
+/**
+ * Reads an option value that must be a fraction strictly between 0 and 1,
+ * such as an error bound or a confidence
+ *
+ * @param option The option's name, for the error message
+ * @param text   The value given for it
+ * @param value  Receives the fraction, left alone if it is not valid
+ * @return True if the value was a fraction between 0 and 1
+ */
+bool read_fraction_option(const std::string &option, const std::string &text, double &value)
+{
+    double fraction;
+    parse_status status = parse_double(text, fraction);
+    if (status != PARSE_OK)
+    {
+        write_line(option + " " + text + ": " + parse_status_message(status));
+        return false;
+    }
+    if (!(fraction > 0 && fraction < 1))
+    {
+        write_line(option + " must be between 0 and 1, not " + text);
+        return false;
+    }
 
-            write("Add another value: [y/n] ");
-            answer = read_line();
+    value = fraction;
+    return true;
+}
 
-            std::transform(answer.begin(), answer.end(), answer.begin(),
-                           [](unsigned char c)
-                           { return std::tolower(c); });
+int main(int argc, char *argv[])
+{
+    // Batch modes:
+    //   SimpleStats --file <numbers.txt> [--threads <n>] [--save <summary>]
+    //   SimpleStats --merge <summary> <summary>... [--save <summary>]
+    //   SimpleStats --group-by <data.csv> --key <column> [--memory <MB>]
+    //   SimpleStats --bench-sketches <n>
+    // Distinct counts and frequent values, with --file or interactively:
+    //   --sketches [--distinct-error <e>] [--frequency-error <e>] [--confidence <p>] [--top <k>]
+    // Interactive windows:
+    //   SimpleStats [--last <n>] [--seconds <t>]
+    // Interactive input saved to, or played back from, a file:
+    //   --record <file> | --replay <file>
+    std::string file_path;
+    std::string save_path;
+    std::vector<std::string> merge_paths;
+    std::string group_path;
+    std::string key_column;
+    size_t group_memory = DEFAULT_GROUP_MEMORY;
+    int threads = std::max(1u, std::thread::hardware_concurrency());
+    long last_count = 100;
+    double last_seconds = 60;
+    bool use_sketches = false;
+    double distinct_error = DEFAULT_DISTINCT_ERROR;
+    double frequency_error = DEFAULT_FREQUENCY_ERROR;
+    double confidence = DEFAULT_FREQUENCY_CONFIDENCE;
+    size_t top_count = 10;
+    size_t benchmark_count = 0;
 
-            if (answer == "y")
+    argc = use_input_script(argc, argv);
+    for (int i = 1; i < argc; i++)
+    {
+        std::string option = argv[i];
+        if (option == "--file" && i + 1 < argc)
+        {
+            file_path = argv[++i];
+        }
+        else if (option == "--threads" && i + 1 < argc)
+        {
+            threads = std::atoi(argv[++i]);
+        }
+        else if (option == "--save" && i + 1 < argc)
+        {
+            save_path = argv[++i];
+        }
+        else if (option == "--group-by" && i + 1 < argc)
+        {
+            group_path = argv[++i];
+        }
+        else if (option == "--key" && i + 1 < argc)
+        {
+            key_column = argv[++i];
+        }
+        else if (option == "--memory" && i + 1 < argc)
+        {
+            group_memory = static_cast<size_t>(std::max(1L, std::atol(argv[++i]))) << 20;
+        }
+        else if (option == "--last" && i + 1 < argc)
+        {
+            last_count = std::max(1L, std::atol(argv[++i]));
+        }
+        else if (option == "--seconds" && i + 1 < argc)
+        {
+            last_seconds = std::max(1.0, std::atof(argv[++i]));
+        }
+        else if (option == "--sketches")
+        {
+            use_sketches = true;
+        }
+        else if (option == "--distinct-error" && i + 1 < argc)
+        {
+            if (!read_fraction_option(option, argv[++i], distinct_error))
+                return 1;
+        }
+        else if (option == "--frequency-error" && i + 1 < argc)
+        {
+            if (!read_fraction_option(option, argv[++i], frequency_error))
+                return 1;
+        }
+        else if (option == "--confidence" && i + 1 < argc)
+        {
+            if (!read_fraction_option(option, argv[++i], confidence))
+                return 1;
+        }
+        else if (option == "--top" && i + 1 < argc)
+        {
+            top_count = static_cast<size_t>(std::max(1L, std::atol(argv[++i])));
+        }
+        else if (option == "--bench-sketches" && i + 1 < argc)
+        {
+            benchmark_count = static_cast<size_t>(std::max(1L, std::atol(argv[++i])));
+        }
+        else if (option == "--merge")
+        {
+            while (i + 1 < argc && std::string(argv[i + 1]).rfind("--", 0) != 0)
             {
-                continue_input = true;
+                merge_paths.push_back(argv[++i]);
             }
-            else if (answer == "n")
+        }
+    }
+
+    if (benchmark_count > 0)
+    {
+        benchmark_sketches(benchmark_count, distinct_error, frequency_error, confidence);
+        return 0;
+    }
+
+    value_sketches sketches;
+    if (use_sketches)
+    {
+        init_value_sketches(sketches, distinct_error, frequency_error, confidence);
+    }
+
+    if (!group_path.empty())
+    {
+        group_table table;
+        std::vector<std::string> names;
+        if (!summarize_groups(group_path, key_column, group_memory, table, names))
+            return 1;
+
+        print_groups(table, names);
+        return 0;
+    }
+
+    if (!file_path.empty() || !merge_paths.empty())
+    {
+        stats_summary result;
+        bool ok = file_path.empty() ? merge_summary_files(merge_paths, result)
+                                    : summarize_file(file_path, threads, result, sketches);
+        if (!ok)
+            return 1;
+
+        print_summary(result);
+        print_sketches(sketches, top_count);
+        if (!save_path.empty() && !save_summary(result, save_path))
+        {
+            write_line("Could not save summary to " + save_path);
+            return 1;
+        }
+        return 0;
+    }
+
+    stats_summary summary;
+    bool continue_input = true;
+    std::string user_input;
+
+    // Windows are timed from the start of the session
+    count_window recent_values;
+    time_window recent_time;
+    tumbling_window minutes;
+    init_count_window(recent_values, static_cast<size_t>(last_count));
+    init_time_window(recent_time, last_seconds, WINDOW_BUCKETS);
+    auto session_start = std::chrono::steady_clock::now();
+
+    write_line("Welcome to the simple stats calculator:");
+    write_line("Enter values one at a time, 's' to show the statistics, 'w' for recent values or 'q' to finish.");
+
+    while (continue_input)
+    {
+        user_input = read_input_line("Enter value: ");
+
+        // Values can also be piped in or replayed, stop at the end of the input
+        if (input_ended() && user_input.empty())
+        {
+            break;
+        }
+
+        std::transform(user_input.begin(), user_input.end(), user_input.begin(),
+                       [](unsigned char c)
+                       { return std::tolower(c); });
+
+        if (user_input == "s")
+        {
+            print_summary(summary);
+            print_sketches(sketches, top_count);
+        }
+        else if (user_input == "w")
+        {
+            double now = std::chrono::duration<double>(std::chrono::steady_clock::now() - session_start).count();
+            print_moments("Last " + std::to_string(recent_values.capacity) + " values", window_stats(recent_values));
+            print_moments("Last " + std::to_string(static_cast<long>(last_seconds)) + " seconds", window_stats(recent_time, now));
+            print_moments("This minute", window_stats(minutes, now));
+        }
+        else if (user_input == "q")
+        {
+            continue_input = false;
+        }
+        else
+        {
+            double value;
+            if (parse_double(user_input, value) == PARSE_OK)
             {
-                continue_input = false;
+                double now = std::chrono::duration<double>(std::chrono::steady_clock::now() - session_start).count();
+                add_value(summary, value);
+                add_to_sketches(sketches, value);
+                add_to_window(recent_values, value);
+                add_to_window(recent_time, now, value);
+                if (add_to_window(minutes, now, value))
+                {
+                    print_moments("Previous minute", minutes.finished);
+                }
             }
             else
             {
-                write_line("Invalid choice. Assuming 'n'.");
-                continue_input = false;
+                write_line("Invalid input. Please enter a valid number.");
             }
         }
-        catch (const std::invalid_argument &)
-        {
-            write_line("Invalid input. Please enter a valid number.");
-        }
     }
 
+    write_line();
+    print_summary(summary);
+    print_sketches(sketches, top_count);
     write_line("I hope you got the information you are after!");
 
     return 0;
-}
\ No newline at end of file
+}
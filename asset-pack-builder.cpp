@@ -0,0 +1,75 @@
+#include "splashkit.h"
+#include "asset_pack.h"
+
+/**
+ * Builds an asset pack: decodes images once, ahead of time, so games can
+ * map the decoded pixels at start up (e.g. to build collision masks)
+ * instead of decoding files or reading pixels back from bitmaps.
+ *
+ * Usage: asset-pack-builder <pack file> <name>=<image file> ...
+ * With no arguments the pack for rock-dodge-game is built. The game saves
+ * the same pack itself on its first launch without one; building it here
+ * saves that launch the readback and lets --headless runs use the masks.
+ */
+
+/**
+ * Decodes an image and adds its pixels to the pack
+ *
+ * @param builder The pack being built
+ * @param name    The name to store the pixels under
+ * @param path    The image file to decode
+ * @return        True if the image was added
+ */
+bool add_image(asset_pack_builder &builder, const string &name, const string &path)
+{
+    bitmap image = load_bitmap(name, path);
+    if (image == nullptr)
+    {
+        write_line("Could not load " + path);
+        return false;
+    }
+
+    if (!add_pack_bitmap(builder, name))
+    {
+        write_line("Could not add " + name + " (names are at most " + std::to_string(ASSET_PACK_NAME_LENGTH - 1) + " characters)");
+        return false;
+    }
+    write_line("Added " + name + ": " + path + " (" + std::to_string(bitmap_width(image)) + "x" + std::to_string(bitmap_height(image)) + ")");
+    return true;
+}
+
+/**
+ * Main function - entry point of the program
+ */
+int main(int argc, char *argv[])
+{
+    string pack_file = "rock-dodge.pack";
+    vector<string> images = {"rock_image=fire_img.png", "player_image=main_char.png"};
+
+    if (argc > 1)
+    {
+        pack_file = argv[1];
+        images.assign(argv + 2, argv + argc);
+    }
+
+    asset_pack_builder builder;
+    for (const string &image : images)
+    {
+        size_t split = image.find('=');
+        if (split == string::npos)
+        {
+            write_line("Expected <name>=<image file>, got " + image);
+            return 1;
+        }
+        if (!add_image(builder, image.substr(0, split), image.substr(split + 1)))
+            return 1;
+    }
+
+    if (!write_asset_pack(builder, pack_file))
+    {
+        write_line("Could not write " + pack_file);
+        return 1;
+    }
+    write_line("Wrote " + pack_file);
+    return 0;
+}
@@ -0,0 +1,243 @@
+#include "asset_pack.h"
+#include "splashkit.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+    const char ASSET_PACK_MAGIC[8] = {'A', 'S', 'S', 'E', 'T', 'P', 'K', '1'};
+    const uint32_t ASSET_PACK_VERSION = 1;
+    const uint64_t DATA_ALIGNMENT = 64;
+
+    struct pack_header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t entry_count;
+        uint64_t file_size;
+        uint64_t reserved;
+    };
+
+    static_assert(sizeof(pack_header) == 32, "asset pack header must stay a fixed size");
+    static_assert(sizeof(asset_pack_entry) == 64, "asset pack entries must stay a fixed size");
+
+    uint64_t align_up(uint64_t offset)
+    {
+        return (offset + DATA_ALIGNMENT - 1) & ~(DATA_ALIGNMENT - 1);
+    }
+
+    bool add_entry(asset_pack_builder &builder, const string &name, asset_pack_kind kind, int width, int height, const vector<uint8_t> &bytes)
+    {
+        if (name.empty() || name.size() >= static_cast<size_t>(ASSET_PACK_NAME_LENGTH))
+            return false;
+
+        asset_pack_entry entry = {};
+        std::memcpy(entry.name, name.c_str(), name.size());
+        entry.kind = kind;
+        entry.width = width;
+        entry.height = height;
+        entry.size = bytes.size();
+        builder.entries.push_back(entry);
+        builder.data.push_back(bytes);
+        return true;
+    }
+
+    uint8_t channel_byte(float channel)
+    {
+        return static_cast<uint8_t>(std::lround(std::min(std::max(channel, 0.0f), 1.0f) * 255));
+    }
+
+    bool write_all(int fd, const void *data, size_t size, uint64_t offset)
+    {
+        const char *bytes = static_cast<const char *>(data);
+        while (size > 0)
+        {
+            ssize_t written = pwrite(fd, bytes, size, static_cast<off_t>(offset));
+            if (written <= 0)
+                return false;
+            bytes += written;
+            size -= written;
+            offset += written;
+        }
+        return true;
+    }
+}
+
+bool add_pack_pixels(asset_pack_builder &builder, const string &name, int width, int height, const vector<uint8_t> &rgba)
+{
+    if (width <= 0 || height <= 0 || rgba.size() != static_cast<size_t>(width) * height * 4)
+        return false;
+    return add_entry(builder, name, PACK_PIXELS, width, height, rgba);
+}
+
+bool add_pack_bitmap(asset_pack_builder &builder, const string &name)
+{
+    if (!has_bitmap(name))
+        return false;
+
+    bitmap image = bitmap_named(name);
+    int width = bitmap_width(image);
+    int height = bitmap_height(image);
+    vector<uint8_t> rgba(static_cast<size_t>(std::max(width, 0)) * std::max(height, 0) * 4);
+    size_t index = 0;
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            color pixel = get_pixel(image, x, y);
+            rgba[index++] = channel_byte(pixel.r);
+            rgba[index++] = channel_byte(pixel.g);
+            rgba[index++] = channel_byte(pixel.b);
+            rgba[index++] = channel_byte(pixel.a);
+        }
+    }
+    return add_pack_pixels(builder, name, width, height, rgba);
+}
+
+bool built_pixels(const asset_pack_builder &builder, const string &name, pixel_view &view)
+{
+    for (size_t i = 0; i < builder.entries.size(); i++)
+    {
+        const asset_pack_entry &entry = builder.entries[i];
+        if (entry.kind == PACK_PIXELS && name == entry.name)
+        {
+            view.pixels = builder.data[i].data();
+            view.width = entry.width;
+            view.height = entry.height;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool write_asset_pack(const asset_pack_builder &builder, const string &path)
+{
+    // Lay the data out after the index, each entry aligned for SIMD and cache lines
+    vector<asset_pack_entry> entries = builder.entries;
+    uint64_t offset = sizeof(pack_header) + entries.size() * sizeof(asset_pack_entry);
+    for (asset_pack_entry &entry : entries)
+    {
+        offset = align_up(offset);
+        entry.offset = offset;
+        offset += entry.size;
+    }
+
+    pack_header header = {};
+    std::memcpy(header.magic, ASSET_PACK_MAGIC, sizeof(ASSET_PACK_MAGIC));
+    header.version = ASSET_PACK_VERSION;
+    header.entry_count = entries.size();
+    header.file_size = offset;
+
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return false;
+
+    bool ok = write_all(fd, &header, sizeof(header), 0) &&
+              write_all(fd, entries.data(), entries.size() * sizeof(asset_pack_entry), sizeof(header));
+    for (size_t i = 0; ok && i < entries.size(); i++)
+    {
+        ok = write_all(fd, builder.data[i].data(), entries[i].size, entries[i].offset);
+    }
+    ok = ok && ftruncate(fd, static_cast<off_t>(header.file_size)) == 0;
+
+    close(fd);
+    return ok;
+}
+
+bool open_asset_pack(asset_pack &pack, const string &path)
+{
+    pack.fd = open(path.c_str(), O_RDONLY);
+    if (pack.fd < 0)
+        return false;
+
+    struct stat info;
+    bool ok = fstat(pack.fd, &info) == 0 && static_cast<size_t>(info.st_size) >= sizeof(pack_header);
+    if (ok)
+    {
+        void *base = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, pack.fd, 0);
+        ok = base != MAP_FAILED;
+        if (ok)
+        {
+            pack.mapping = base;
+            pack.mapping_size = info.st_size;
+        }
+    }
+
+    if (ok)
+    {
+        const pack_header &header = *static_cast<const pack_header *>(pack.mapping);
+        ok = std::memcmp(header.magic, ASSET_PACK_MAGIC, sizeof(ASSET_PACK_MAGIC)) == 0 &&
+             header.version == ASSET_PACK_VERSION &&
+             header.file_size == pack.mapping_size &&
+             sizeof(pack_header) + static_cast<uint64_t>(header.entry_count) * sizeof(asset_pack_entry) <= pack.mapping_size;
+
+        if (ok)
+        {
+            pack.entries = reinterpret_cast<const asset_pack_entry *>(static_cast<const char *>(pack.mapping) + sizeof(pack_header));
+            pack.entry_count = header.entry_count;
+        }
+
+        // Check every entry once here so lookups can trust the index
+        for (uint32_t i = 0; ok && i < pack.entry_count; i++)
+        {
+            const asset_pack_entry &entry = pack.entries[i];
+            ok = entry.name[ASSET_PACK_NAME_LENGTH - 1] == '\0' &&
+                 entry.offset <= pack.mapping_size &&
+                 entry.size <= pack.mapping_size - entry.offset &&
+                 (entry.kind != PACK_PIXELS ||
+                  (entry.width > 0 && entry.height > 0 &&
+                   entry.size == static_cast<uint64_t>(entry.width) * entry.height * 4));
+        }
+    }
+
+    if (!ok)
+    {
+        close_asset_pack(pack);
+    }
+    return ok;
+}
+
+void close_asset_pack(asset_pack &pack)
+{
+    if (pack.mapping)
+    {
+        munmap(const_cast<void *>(pack.mapping), pack.mapping_size);
+        pack.mapping = nullptr;
+        pack.mapping_size = 0;
+    }
+    pack.entries = nullptr;
+    pack.entry_count = 0;
+    if (pack.fd >= 0)
+    {
+        close(pack.fd);
+        pack.fd = -1;
+    }
+}
+
+const asset_pack_entry *find_pack_entry(const asset_pack &pack, const string &name)
+{
+    for (uint32_t i = 0; i < pack.entry_count; i++)
+    {
+        if (name == pack.entries[i].name)
+            return &pack.entries[i];
+    }
+    return nullptr;
+}
+
+bool pack_pixels(const asset_pack &pack, const string &name, pixel_view &view)
+{
+    const asset_pack_entry *entry = find_pack_entry(pack, name);
+    if (!entry || entry->kind != PACK_PIXELS)
+        return false;
+
+    view.pixels = static_cast<const uint8_t *>(pack.mapping) + entry->offset;
+    view.width = entry->width;
+    view.height = entry->height;
+    return true;
+}
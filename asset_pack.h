@@ -0,0 +1,155 @@
+#ifndef ASSET_PACK_H
+#define ASSET_PACK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+using std::string;
+using std::vector;
+
+const int ASSET_PACK_NAME_LENGTH = 32;
+
+// What an entry in a pack holds
+enum asset_pack_kind : uint32_t
+{
+    PACK_PIXELS = 1 // decoded RGBA8 pixels, row major, no row padding
+};
+
+/**
+ * An entry in the pack index. Entries are fixed size so the index can be
+ * read straight out of the mapped file.
+ *
+ * @field name   the name the asset is looked up by, zero padded
+ * @field kind   an asset_pack_kind
+ * @field width  width in pixels (PACK_PIXELS only)
+ * @field height height in pixels (PACK_PIXELS only)
+ * @field offset where the data starts in the file, 64 byte aligned
+ * @field size   how many bytes of data there are
+ */
+struct asset_pack_entry
+{
+    char name[ASSET_PACK_NAME_LENGTH];
+    uint32_t kind;
+    uint32_t width;
+    uint32_t height;
+    uint32_t reserved;
+    uint64_t offset;
+    uint64_t size;
+};
+
+/**
+ * An open asset pack. The whole file is memory mapped read only, so asset
+ * data is used in place without being copied or decoded.
+ *
+ * File layout: a header (magic, version, entry count), the index of
+ * entries, then each entry's data.
+ */
+struct asset_pack
+{
+    int fd = -1;
+    const void *mapping = nullptr;
+    size_t mapping_size = 0;
+    const asset_pack_entry *entries = nullptr;
+    uint32_t entry_count = 0;
+};
+
+/**
+ * Decoded pixels inside a mapped pack. Each pixel is 4 bytes: red, green,
+ * blue and alpha, in that order in memory.
+ */
+struct pixel_view
+{
+    const uint8_t *pixels = nullptr;
+    int width = 0;
+    int height = 0;
+};
+
+/**
+ * An asset pack being built in memory, see write_asset_pack
+ */
+struct asset_pack_builder
+{
+    vector<asset_pack_entry> entries;
+    vector<vector<uint8_t>> data;
+};
+
+/**
+ * Add decoded pixels to a pack being built.
+ *
+ * @param builder the pack being built
+ * @param name    the name to store the pixels under
+ * @param width   width in pixels
+ * @param height  height in pixels
+ * @param rgba    width * height * 4 bytes of RGBA8 pixels
+ * @returns false if the name is too long or the pixels are the wrong size
+ */
+bool add_pack_pixels(asset_pack_builder &builder, const string &name, int width, int height, const vector<uint8_t> &rgba);
+
+/**
+ * Read a loaded bitmap's pixels back and add them to a pack being built.
+ * Reading back is slow, one pixel at a time, so it is done once and the
+ * pack saved for later.
+ *
+ * @param builder the pack being built
+ * @param name    the name the bitmap was loaded under, also used in the pack
+ * @returns false if there is no such bitmap or the name is too long
+ */
+bool add_pack_bitmap(asset_pack_builder &builder, const string &name);
+
+/**
+ * Get the pixels added to a pack being built under a name, without copying
+ * them. The view is valid until the builder changes.
+ *
+ * @param builder the pack being built
+ * @param name    the name to look for
+ * @param view    set to the pixels if they are found
+ * @returns true if the builder has pixels with that name
+ */
+bool built_pixels(const asset_pack_builder &builder, const string &name, pixel_view &view);
+
+/**
+ * Write a built pack to a file.
+ *
+ * @param builder the pack to write
+ * @param path    the file to write
+ * @returns true if the whole pack was written
+ */
+bool write_asset_pack(const asset_pack_builder &builder, const string &path);
+
+/**
+ * Map a pack file and check its index.
+ *
+ * @param pack the pack to open
+ * @param path the file to open
+ * @returns true if the file is a valid pack
+ */
+bool open_asset_pack(asset_pack &pack, const string &path);
+
+/**
+ * Unmap and close a pack. Views into it are no longer valid.
+ *
+ * @param pack the pack to close
+ */
+void close_asset_pack(asset_pack &pack);
+
+/**
+ * Find an entry in a pack by name.
+ *
+ * @param pack the open pack
+ * @param name the name to look for
+ * @returns the entry, or nullptr if there is none
+ */
+const asset_pack_entry *find_pack_entry(const asset_pack &pack, const string &name);
+
+/**
+ * Get the pixels stored under a name, without copying them.
+ *
+ * @param pack the open pack
+ * @param name the name to look for
+ * @param view set to the pixels if they are found
+ * @returns true if the pack has pixels with that name
+ */
+bool pack_pixels(const asset_pack &pack, const string &name, pixel_view &view);
+
+#endif
@@ -1,4 +1,8 @@
 #include "splashkit.h"
+#include "output_buffer.h"
+#include "terminal_ui.h"
+#include "number_parsing.h"
+#include "input_script.h"
 #include <string>
 
 /**
@@ -30,11 +34,13 @@ string format_currency(double amount)
  */
 void display_account(const bank_account &account)
 {
-    write_line("===== ACCOUNT DETAILS =====");
-    write_line("Account Name: " + account.name);
-    write_line("Interest Rate: " + std::to_string(account.interest_rate) + "%");
-    write_line("Balance: $" + format_currency(account.balance));
-    write_line("===========================");
+    output_buffer &out = console_output();
+    buffer_write_line(out, "===== ACCOUNT DETAILS =====");
+    buffer_write_line(out, "Account Name: " + account.name);
+    buffer_write_line(out, "Interest Rate: " + std::to_string(account.interest_rate) + "%");
+    buffer_write_line(out, "Balance: $" + format_currency(account.balance));
+    buffer_write_line(out, "===========================");
+    flush_output(out);
 }
 
 /**
@@ -51,12 +57,13 @@ void perform_deposit(bank_account &account)
 
     while (!valid_input)
     {
-        write("Enter amount to deposit (or 0 to cancel): $");
-        string input = read_line();
+        string input = read_input_line("Enter amount to deposit (or 0 to cancel): $");
 
-        amount = convert_to_double(input);
-
-        if (amount < 0)
+        if (parse_double(input, amount) != PARSE_OK)
+        {
+            write_line("Error: Please enter a valid number");
+        }
+        else if (amount < 0)
         {
             write_line("Error: Please enter a value greater than or equal to 0");
         }
@@ -91,12 +98,13 @@ void perform_withdraw(bank_account &account)
 
     while (!valid_input)
     {
-        write("Enter amount to withdraw (or 0 to cancel): $");
-        string input = read_line();
+        string input = read_input_line("Enter amount to withdraw (or 0 to cancel): $");
 
-        amount = convert_to_double(input);
-
-        if (amount < 0)
+        if (parse_double(input, amount) != PARSE_OK)
+        {
+            write_line("Error: Please enter a valid number");
+        }
+        else if (amount < 0)
         {
             write_line("Error: Please enter a value greater than or equal to 0");
         }
@@ -135,12 +143,10 @@ void add_interest(bank_account &account)
 
     while (!valid_input)
     {
-        write("Enter number of days (or 0 to cancel): ");
-        string input = read_line();
+        string input = read_input_line("Enter number of days (or 0 to cancel): ");
 
-        if (is_number(input))
+        if (parse_int(input, days) == PARSE_OK)
         {
-            days = convert_to_integer(input);
             if (days >= 0)
             {
                 valid_input = true;
@@ -186,18 +192,15 @@ bank_account create_account()
 
     write_line("\n===== NEW ACCOUNT SETUP =====");
 
-    write("Enter account name: ");
-    result.name = read_line();
+    result.name = read_input_line("Enter account name: ");
 
     bool valid_rate = false;
     while (!valid_rate)
     {
-        write("Enter interest rate (%): ");
-        string rate_input = read_line();
+        string rate_input = read_input_line("Enter interest rate (%): ");
 
-        if (is_number(rate_input))
+        if (parse_double(rate_input, result.interest_rate) == PARSE_OK)
         {
-            result.interest_rate = convert_to_double(rate_input);
             valid_rate = true;
         }
         else
@@ -209,12 +212,10 @@ bank_account create_account()
     bool valid_balance = false;
     while (!valid_balance)
     {
-        write("Enter initial balance ($): ");
-        string balance_input = read_line();
+        string balance_input = read_input_line("Enter initial balance ($): ");
 
-        if (is_number(balance_input))
+        if (parse_double(balance_input, result.balance) == PARSE_OK)
         {
-            result.balance = convert_to_double(balance_input);
             if (result.balance < 0)
             {
                 write_line("Error: Balance cannot be negative.");
@@ -239,36 +240,87 @@ bank_account create_account()
  */
 void display_main_menu()
 {
-    write_line("\n===== BANK ACCOUNT MANAGEMENT =====");
-    write_line("1: View Account Details");
-    write_line("2: Deposit");
-    write_line("3: Withdraw");
-    write_line("4: Add Interest");
-    write_line("5: Quit");
+    output_buffer &out = console_output();
+    buffer_write_line(out, "\n===== BANK ACCOUNT MANAGEMENT =====");
+    buffer_write_line(out, "1: View Account Details");
+    buffer_write_line(out, "2: Deposit");
+    buffer_write_line(out, "3: Withdraw");
+    buffer_write_line(out, "4: Add Interest");
+    buffer_write_line(out, "5: Quit");
+    buffer_write(out, "Select an option (1-5): ");
+    flush_output(out);
+}
+
+/**
+ * @brief Draws the account and menu into a panel fixed at the top of the terminal,
+ * sending only what changed since the last time, then prompts below it
+ * @param screen The panel to draw into
+ * @param account The bank account to display
+ */
+void display_dashboard(terminal_screen &screen, const bank_account &account)
+{
+    clear_screen_buffer(screen);
+    fill_row(screen, 0, STYLE_INVERSE);
+    put_text(screen, 1, 0, "BANK ACCOUNT MANAGEMENT", STYLE_INVERSE | STYLE_BOLD);
+
+    put_text(screen, 1, 2, "Account Name:  " + account.name);
+    put_text(screen, 1, 3, "Interest Rate: " + std::to_string(account.interest_rate) + "%");
+    put_text(screen, 1, 4, "Balance:       $" + format_currency(account.balance), STYLE_BOLD);
+
+    put_text(screen, 1, 6, "1: View Account Details");
+    put_text(screen, 1, 7, "2: Deposit");
+    put_text(screen, 1, 8, "3: Withdraw");
+    put_text(screen, 1, 9, "4: Add Interest");
+    put_text(screen, 1, 10, "5: Quit");
+    put_text(screen, 0, 11, string(screen.width, '-'));
+    present_screen(screen);
+
     write("Select an option (1-5): ");
 }
 
 /**
  * @brief Main program function
+ * @param argc Number of command line arguments
+ * @param argv Command line arguments, --tui keeps the account and menu on screen,
+ *             --record/--replay <file> save or play back the input
  * @return Program exit code (0 for normal exit)
  */
-int main()
+int main(int argc, char *argv[])
 {
+    argc = use_input_script(argc, argv);
+    bool use_tui = argc > 1 && string(argv[1]) == "--tui";
 
     bank_account user_account = create_account();
 
+    terminal_screen screen;
+    if (use_tui)
+    {
+        open_terminal_screen(screen, 60, 12);
+    }
+
     bool quit = false;
 
     while (!quit)
     {
 
-        display_main_menu();
+        if (use_tui)
+        {
+            display_dashboard(screen, user_account);
+        }
+        else
+        {
+            display_main_menu();
+        }
 
-        string choice = read_line();
+        string choice = read_input_line();
 
         if (choice == "1")
         {
-            display_account(user_account);
+            // The dashboard already shows the details
+            if (!use_tui)
+            {
+                display_account(user_account);
+            }
         }
         else if (choice == "2")
         {
@@ -284,6 +336,7 @@ int main()
         }
         else if (choice == "5")
         {
+            close_terminal_screen(screen);
             write_line("Thank you for using the Bank Account Management System. Goodbye!");
             quit = true;
         }
@@ -0,0 +1,187 @@
+#ifndef ENUM_REFLECTION_H
+#define ENUM_REFLECTION_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/*
+ * Names for enums whose values run 0, 1, 2, ... built at compile time from
+ * a single list. Declare the list once as an X-macro:
+ *
+ *     #define SHAPE_LIST(X) X(CIRCLE, "circle") X(SQUARE, "square")
+ *     enum shape { SHAPE_LIST(ENUM_VALUE) };
+ *     constexpr auto SHAPE_NAMES = make_enum_names<shape>({SHAPE_LIST(ENUM_NAME)});
+ *
+ * Adding a value to the list then updates the enum, its names and the
+ * lookup table together.
+ */
+#define ENUM_VALUE(value, name) value,
+#define ENUM_NAME(value, name) name,
+
+/**
+ * Hash text for the name lookup table, started from a seed so that a seed
+ * giving no collisions can be searched for. The short form only looks at
+ * the length and the first, middle and last characters, which tells most
+ * lists of names apart in a few instructions; the full form hashes every
+ * character (FNV-1a) for lists that it doesn't.
+ *
+ * @param text the text to hash
+ * @param seed varies the hash
+ * @param full whether to hash every character
+ * @returns the hash
+ */
+constexpr uint32_t enum_name_hash(std::string_view text, uint32_t seed, bool full)
+{
+    uint32_t hash = 2166136261u ^ (seed * 0x9e3779b9u);
+    if (full)
+    {
+        for (char c : text)
+        {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= 16777619u;
+        }
+    }
+    else if (!text.empty())
+    {
+        uint32_t key = static_cast<uint32_t>(text.size()) |
+                       static_cast<uint32_t>(static_cast<unsigned char>(text.front())) << 8 |
+                       static_cast<uint32_t>(static_cast<unsigned char>(text[text.size() / 2])) << 16 |
+                       static_cast<uint32_t>(static_cast<unsigned char>(text.back())) << 24;
+        hash = (hash ^ key) * 0x9e3779b1u;
+    }
+    return hash ^ (hash >> 15);
+}
+
+/**
+ * The size of the lookup table for a number of names: a power of two at
+ * least twice the count, so a collision-free seed is quick to find.
+ *
+ * @param count how many names
+ * @returns slots in the table
+ */
+constexpr size_t enum_table_size(size_t count)
+{
+    size_t size = 2;
+    while (size < 2 * count)
+        size *= 2;
+    return size;
+}
+
+/**
+ * The names of an enum's values and a perfect hash table to look them up.
+ * Each name hashes to its own slot, so parsing is one hash, one index and
+ * one comparison, with no allocation.
+ *
+ * @field names  the name of each value, in order
+ * @field seed   the hash seed that puts every name in its own slot
+ * @field full   whether names are hashed in full, see enum_name_hash
+ * @field slots  for each slot, the value hashed there plus one, or 0 if empty
+ */
+template <typename Enum, size_t N>
+struct enum_names
+{
+    std::array<std::string_view, N> names{};
+    uint32_t seed = 0;
+    bool full = false;
+    std::array<uint8_t, enum_table_size(N)> slots{};
+};
+
+/**
+ * Build the names and lookup table for an enum. Used in a constexpr
+ * definition, so the seed search happens while compiling; a list that
+ * can't be hashed (e.g. two values with the same name) fails to compile.
+ *
+ * @param names the name of each value, in order
+ * @returns the names and their lookup table
+ */
+template <typename Enum, size_t N>
+constexpr enum_names<Enum, N> make_enum_names(const std::string_view (&names)[N])
+{
+    static_assert(N > 0 && N < 255, "enum_names holds 1 to 254 values");
+
+    enum_names<Enum, N> result;
+    for (size_t i = 0; i < N; i++)
+    {
+        result.names[i] = names[i];
+    }
+
+    // Try the short hash first, then hashing the names in full
+    const size_t mask = result.slots.size() - 1;
+    for (int pass = 0; pass < 2; pass++)
+    {
+        result.full = pass == 1;
+        for (uint32_t seed = 0; seed < 10000; seed++)
+        {
+            result.seed = seed;
+            result.slots = {};
+            bool collided = false;
+            for (size_t i = 0; i < N && !collided; i++)
+            {
+                size_t slot = enum_name_hash(names[i], seed, result.full) & mask;
+                collided = result.slots[slot] != 0;
+                result.slots[slot] = static_cast<uint8_t>(i + 1);
+            }
+            if (!collided)
+                return result;
+        }
+    }
+
+    // Not constant, so failing to find a seed stops compilation
+    throw "no perfect hash seed for these enum names";
+}
+
+/**
+ * The name of an enum value.
+ *
+ * @param table the enum's names
+ * @param value the value
+ * @returns its name, or "unknown" if it is not one of the enum's values
+ */
+template <typename Enum, size_t N>
+constexpr std::string_view enum_to_name(const enum_names<Enum, N> &table, Enum value)
+{
+    size_t index = static_cast<size_t>(value);
+    return index < N ? table.names[index] : std::string_view("unknown");
+}
+
+/**
+ * Find the enum value with a name. The name must match exactly.
+ *
+ * @param table  the enum's names
+ * @param text   the name to look up
+ * @param result receives the value, left alone if there isn't one
+ * @returns true if the name belongs to a value
+ */
+template <typename Enum, size_t N>
+constexpr bool enum_from_name(const enum_names<Enum, N> &table, std::string_view text, Enum &result)
+{
+    size_t slot = enum_name_hash(text, table.seed, table.full) & (table.slots.size() - 1);
+    int index = table.slots[slot] - 1;
+    if (index < 0 || table.names[index] != text)
+        return false;
+
+    result = static_cast<Enum>(index);
+    return true;
+}
+
+/**
+ * Convert an integer to an enum value, checking it is one.
+ *
+ * @param table  the enum's names
+ * @param value  the integer
+ * @param result receives the value, left alone if the integer is out of range
+ * @returns true if the integer is one of the enum's values
+ */
+template <typename Enum, size_t N>
+constexpr bool enum_from_int(const enum_names<Enum, N> &table, int value, Enum &result)
+{
+    if (value < 0 || static_cast<size_t>(value) >= table.names.size())
+        return false;
+
+    result = static_cast<Enum>(value);
+    return true;
+}
+
+#endif
@@ -0,0 +1,150 @@
+#include "frame_profiler.h"
+#include "splashkit.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace
+{
+    const char *const ZONE_NAMES[PROFILE_ZONE_COUNT] = {"input", "update", "collision", "draw"};
+
+    const double HUD_LINE_HEIGHT = 14;
+    // The graph fills the HUD below the text lines, less the margins
+    const double GRAPH_HEIGHT = PROFILER_HUD_HEIGHT - (PROFILE_ZONE_COUNT + 2) * HUD_LINE_HEIGHT - 10;
+    const double GRAPH_MAX_MS = 33.3;     // Frame times above this are clipped
+    const double TARGET_FRAME_MS = 16.67; // Marked on the graph
+
+    float nanoseconds_to_ms(int64_t ns)
+    {
+        return static_cast<float>(ns / 1e6);
+    }
+
+    string format_ms(double ms)
+    {
+        char text[32];
+        std::snprintf(text, sizeof(text), "%6.2f ms", ms);
+        return text;
+    }
+}
+
+bool start_profile_csv(frame_profiler &profiler, const string &path)
+{
+    profiler.csv.open(path);
+    if (!profiler.csv)
+        return false;
+
+    profiler.csv << "frame,frame_ms";
+    for (const char *name : ZONE_NAMES)
+    {
+        profiler.csv << "," << name << "_ms";
+    }
+    profiler.csv << "\n";
+    return true;
+}
+
+bool profiler_active(const frame_profiler &profiler)
+{
+    return profiler.hud_visible || profiler.csv.is_open();
+}
+
+zone_times *profile_zones(frame_profiler &profiler)
+{
+    return profiler_active(profiler) ? &profiler.current : nullptr;
+}
+
+void begin_profile_frame(frame_profiler &profiler)
+{
+    // Recorded even when inactive, so the frame the HUD is turned on in measures from its real start
+    profiler.frame_start = std::chrono::steady_clock::now();
+}
+
+void add_zone_times(frame_profiler &profiler, const zone_times &times)
+{
+    for (int zone = 0; zone < PROFILE_ZONE_COUNT; zone++)
+    {
+        profiler.current.ns[zone] += times.ns[zone];
+    }
+}
+
+void end_profile_frame(frame_profiler &profiler)
+{
+    if (!profiler_active(profiler))
+        return;
+
+    int slot = profiler.next;
+    profiler.frame_ms[slot] = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - profiler.frame_start).count();
+    for (int zone = 0; zone < PROFILE_ZONE_COUNT; zone++)
+    {
+        profiler.zone_ms[slot][zone] = nanoseconds_to_ms(profiler.current.ns[zone]);
+    }
+    profiler.next = (slot + 1) % PROFILE_HISTORY;
+    profiler.count = std::min(profiler.count + 1, PROFILE_HISTORY);
+
+    if (profiler.csv.is_open())
+    {
+        profiler.csv << profiler.frame << "," << profiler.frame_ms[slot];
+        for (int zone = 0; zone < PROFILE_ZONE_COUNT; zone++)
+        {
+            profiler.csv << "," << profiler.zone_ms[slot][zone];
+        }
+        profiler.csv << "\n";
+    }
+
+    profiler.frame++;
+    profiler.current = zone_times();
+}
+
+void toggle_profiler_hud(frame_profiler &profiler)
+{
+    profiler.hud_visible = !profiler.hud_visible;
+    profiler.current = zone_times();
+    profiler.next = 0;
+    profiler.count = 0;
+}
+
+void draw_profiler_hud(const frame_profiler &profiler, double x, double y)
+{
+    if (!profiler.hud_visible)
+        return;
+
+    // Rolling averages over the history
+    double average_frame = 0;
+    double average_zone[PROFILE_ZONE_COUNT] = {};
+    for (int i = 0; i < profiler.count; i++)
+    {
+        average_frame += profiler.frame_ms[i];
+        for (int zone = 0; zone < PROFILE_ZONE_COUNT; zone++)
+        {
+            average_zone[zone] += profiler.zone_ms[i][zone];
+        }
+    }
+    int samples = std::max(profiler.count, 1);
+
+    fill_rectangle(rgba_color(0, 0, 0, 180), x, y, PROFILER_HUD_WIDTH, PROFILER_HUD_HEIGHT);
+
+    double line_y = y + 5;
+    draw_text("frame     " + format_ms(average_frame / samples), COLOR_WHITE, x + 5, line_y);
+    for (int zone = 0; zone < PROFILE_ZONE_COUNT; zone++)
+    {
+        line_y += HUD_LINE_HEIGHT;
+        string name = ZONE_NAMES[zone];
+        name.resize(10, ' ');
+        draw_text(name + format_ms(average_zone[zone] / samples), COLOR_WHITE, x + 5, line_y);
+    }
+
+    // Frame time graph, oldest on the left, with the 60 fps budget marked
+    double graph_top = line_y + 2 * HUD_LINE_HEIGHT;
+    double graph_bottom = graph_top + GRAPH_HEIGHT;
+    double bar_width = (PROFILER_HUD_WIDTH - 10) / PROFILE_HISTORY;
+    double target_y = graph_bottom - GRAPH_HEIGHT * TARGET_FRAME_MS / GRAPH_MAX_MS;
+    draw_line(COLOR_GREEN, x + 5, target_y, x + PROFILER_HUD_WIDTH - 5, target_y);
+
+    int oldest = profiler.count < PROFILE_HISTORY ? 0 : profiler.next;
+    for (int i = 0; i < profiler.count; i++)
+    {
+        float frame_ms = profiler.frame_ms[(oldest + i) % PROFILE_HISTORY];
+        double bar_height = GRAPH_HEIGHT * std::min<double>(frame_ms, GRAPH_MAX_MS) / GRAPH_MAX_MS;
+        double bar_x = x + 5 + i * bar_width;
+        draw_line(frame_ms > TARGET_FRAME_MS ? COLOR_RED : COLOR_WHITE, bar_x, graph_bottom, bar_x, graph_bottom - bar_height);
+    }
+}
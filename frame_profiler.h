@@ -0,0 +1,153 @@
+#ifndef FRAME_PROFILER_H
+#define FRAME_PROFILER_H
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <string>
+using std::string;
+
+// Frames kept for the rolling averages and the frame time graph
+const int PROFILE_HISTORY = 240;
+
+// The phases of a frame that are timed. Zones may nest (collision is
+// usually timed inside update), each is reported on its own.
+enum profile_zone
+{
+    PROFILE_INPUT,
+    PROFILE_UPDATE,
+    PROFILE_COLLISION,
+    PROFILE_DRAW,
+    PROFILE_ZONE_COUNT
+};
+
+// Size of the HUD, so programs that only repaint what changed can cover it up
+const double PROFILER_HUD_WIDTH = 260;
+const double PROFILER_HUD_HEIGHT = 154;
+
+/**
+ * Time spent in each zone during one frame. A thread other than the main
+ * one fills its own zone_times and hands them over with add_zone_times.
+ */
+struct zone_times
+{
+    int64_t ns[PROFILE_ZONE_COUNT] = {};
+};
+
+/**
+ * Times the enclosing scope into a zone. With nullptr times (profiling
+ * off) it does nothing, not even read the clock.
+ */
+struct profile_scope
+{
+    zone_times *times;
+    profile_zone zone;
+    std::chrono::steady_clock::time_point start;
+
+    profile_scope(zone_times *times, profile_zone zone) : times(times), zone(zone)
+    {
+        if (times)
+            start = std::chrono::steady_clock::now();
+    }
+
+    ~profile_scope()
+    {
+        if (times)
+            times->ns[zone] += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    }
+};
+
+/**
+ * Per frame zone timings, kept while the HUD is shown or a CSV trace is
+ * being written and skipped entirely otherwise.
+ *
+ * @field hud_visible Whether draw_profiler_hud draws anything
+ * @field csv         The CSV trace, open only when exporting
+ * @field current     Zone times of the frame in progress
+ * @field frame_start When the frame in progress began
+ * @field frame       Number of frames profiled
+ * @field frame_ms    Ring of recent frame times
+ * @field zone_ms     Ring of recent zone times
+ * @field next        Next slot to write in the rings
+ * @field count       Slots of the rings in use
+ */
+struct frame_profiler
+{
+    bool hud_visible = false;
+    std::ofstream csv;
+    zone_times current;
+    std::chrono::steady_clock::time_point frame_start;
+    int64_t frame = 0;
+    float frame_ms[PROFILE_HISTORY] = {};
+    float zone_ms[PROFILE_HISTORY][PROFILE_ZONE_COUNT] = {};
+    int next = 0;
+    int count = 0;
+};
+
+/**
+ * Start exporting every frame's zone timings to a CSV file.
+ *
+ * @param profiler the profiler
+ * @param path     the file to write
+ * @returns true if the file could be opened
+ */
+bool start_profile_csv(frame_profiler &profiler, const string &path);
+
+/**
+ * Whether timings are being collected at all.
+ *
+ * @param profiler the profiler
+ * @returns true if the HUD is shown or a CSV trace is being written
+ */
+bool profiler_active(const frame_profiler &profiler);
+
+/**
+ * Where this frame's zone times go, for profile_scope.
+ *
+ * @param profiler the profiler
+ * @returns the current frame's times, or nullptr when profiling is off
+ */
+zone_times *profile_zones(frame_profiler &profiler);
+
+/**
+ * Mark the start of a frame. Call it every frame, profiling or not.
+ *
+ * @param profiler the profiler
+ */
+void begin_profile_frame(frame_profiler &profiler);
+
+/**
+ * Add zone times measured elsewhere (e.g. on another thread) to the
+ * current frame.
+ *
+ * @param profiler the profiler
+ * @param times    the times to add
+ */
+void add_zone_times(frame_profiler &profiler, const zone_times &times);
+
+/**
+ * Mark the end of a frame: record its times in the history and the CSV
+ * trace, and start a fresh set of zone times.
+ *
+ * @param profiler the profiler
+ */
+void end_profile_frame(frame_profiler &profiler);
+
+/**
+ * Show or hide the HUD. The history restarts when it is shown.
+ *
+ * @param profiler the profiler
+ */
+void toggle_profiler_hud(frame_profiler &profiler);
+
+/**
+ * Draw the HUD, if it is visible: rolling average zone and frame times
+ * and a graph of recent frame times.
+ *
+ * @param profiler the profiler
+ * @param x        left edge of the HUD
+ * @param y        top edge of the HUD
+ */
+void draw_profiler_hud(const frame_profiler &profiler, double x, double y);
+
+#endif
@@ -0,0 +1,347 @@
+#include "high_score_table.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <cerrno>
+#include <ctime>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+    const char HIGH_SCORE_MAGIC[8] = {'H', 'I', 'S', 'C', 'O', 'R', 'E', '1'};
+    const uint32_t HIGH_SCORE_VERSION = 1;
+    const size_t HEADER_SIZE = 4096;
+
+    // An index entry: a record's score and where to find it
+    struct heap_entry
+    {
+        int32_t score;
+        uint32_t reserved;
+        uint64_t record_index;
+    };
+
+    // The header page, heap[0] is the lowest of the top scores
+    struct table_header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t record_size;
+        uint32_t top_k;
+        uint32_t heap_size;
+        uint64_t indexed_count; // records [0, indexed_count) are reflected in the heap
+        uint32_t index_checksum;
+        uint32_t reserved;
+        heap_entry heap[HIGH_SCORE_TOP_K];
+    };
+
+    static_assert(sizeof(table_header) <= HEADER_SIZE, "high score header must fit in one page");
+    static_assert(sizeof(high_score_record) == 48, "high score records must stay a fixed size");
+
+    // 32-bit FNV-1a hash
+    uint32_t checksum(const void *data, size_t size, uint32_t hash = 2166136261u)
+    {
+        const unsigned char *bytes = static_cast<const unsigned char *>(data);
+        for (size_t i = 0; i < size; i++)
+        {
+            hash = (hash ^ bytes[i]) * 16777619u;
+        }
+        return hash;
+    }
+
+    // Take or release the file lock, retrying if a signal interrupts the wait
+    bool lock_table(const high_score_table &table, int operation)
+    {
+        int result;
+        do
+        {
+            result = flock(table.fd, operation);
+        } while (result != 0 && errno == EINTR);
+        return result == 0;
+    }
+
+    uint32_t record_checksum(const high_score_record &record)
+    {
+        return checksum(&record, offsetof(high_score_record, checksum));
+    }
+
+    uint32_t index_checksum(const table_header &header)
+    {
+        uint32_t hash = checksum(&header.heap_size, sizeof(header.heap_size));
+        hash = checksum(&header.indexed_count, sizeof(header.indexed_count), hash);
+        return checksum(header.heap, sizeof(heap_entry) * std::min<uint32_t>(header.heap_size, HIGH_SCORE_TOP_K), hash);
+    }
+
+    table_header &header_of(high_score_table &table)
+    {
+        return *static_cast<table_header *>(table.header);
+    }
+
+    // Number of complete records, a torn record at the end is ignored
+    uint64_t record_count(int fd)
+    {
+        struct stat info;
+        if (fstat(fd, &info) != 0 || static_cast<size_t>(info.st_size) < HEADER_SIZE)
+            return 0;
+        return (info.st_size - HEADER_SIZE) / sizeof(high_score_record);
+    }
+
+    void unmap_records(high_score_table &table)
+    {
+        if (table.mapping)
+        {
+            munmap(table.mapping, table.mapping_size);
+            table.mapping = nullptr;
+            table.mapping_size = 0;
+        }
+    }
+
+    // (Re)map the whole file read only so records can be read in place
+    const high_score_record *map_records(high_score_table &table)
+    {
+        struct stat info;
+        if (fstat(table.fd, &info) != 0)
+            return nullptr;
+
+        size_t size = static_cast<size_t>(info.st_size);
+        if (size != table.mapping_size || !table.mapping)
+        {
+            unmap_records(table);
+            void *base = mmap(nullptr, size, PROT_READ, MAP_SHARED, table.fd, 0);
+            if (base == MAP_FAILED)
+                return nullptr;
+            table.mapping = base;
+            table.mapping_size = size;
+        }
+
+        return reinterpret_cast<const high_score_record *>(static_cast<char *>(table.mapping) + HEADER_SIZE);
+    }
+
+    // Add a record to the min-heap of the best HIGH_SCORE_TOP_K scores
+    void heap_insert(table_header &header, int32_t score, uint64_t record_index)
+    {
+        heap_entry *heap = header.heap;
+        uint32_t size = header.heap_size;
+
+        if (size < HIGH_SCORE_TOP_K)
+        {
+            // Sift the new entry up
+            uint32_t i = size;
+            while (i > 0 && heap[(i - 1) / 2].score > score)
+            {
+                heap[i] = heap[(i - 1) / 2];
+                i = (i - 1) / 2;
+            }
+            heap[i] = {score, 0, record_index};
+            header.heap_size = size + 1;
+            return;
+        }
+
+        if (score <= heap[0].score)
+            return;
+
+        // Replace the lowest score and sift down
+        uint32_t i = 0;
+        while (true)
+        {
+            uint32_t child = 2 * i + 1;
+            if (child >= size)
+                break;
+            if (child + 1 < size && heap[child + 1].score < heap[child].score)
+                child++;
+            if (heap[child].score >= score)
+                break;
+            heap[i] = heap[child];
+            i = child;
+        }
+        heap[i] = {score, 0, record_index};
+    }
+
+    // Bring the index up to date with the records. Must be called with the file locked.
+    bool repair_index(high_score_table &table)
+    {
+        table_header &header = header_of(table);
+        uint64_t count = record_count(table.fd);
+
+        // A bad checksum means a writer died mid update: rebuild from scratch
+        if (header.heap_size > HIGH_SCORE_TOP_K || header.indexed_count > count ||
+            header.index_checksum != index_checksum(header))
+        {
+            header.heap_size = 0;
+            header.indexed_count = 0;
+        }
+
+        if (header.indexed_count < count)
+        {
+            const high_score_record *records = map_records(table);
+            if (!records)
+                return false;
+
+            // Only the records appended since the last index update are scanned
+            for (uint64_t i = header.indexed_count; i < count; i++)
+            {
+                const high_score_record &record = records[i];
+                if (record.checksum == record_checksum(record))
+                {
+                    heap_insert(header, record.score, i);
+                }
+            }
+            header.indexed_count = count;
+        }
+
+        header.index_checksum = index_checksum(header);
+        return true;
+    }
+}
+
+bool open_high_score_table(high_score_table &table, const string &path)
+{
+    table.fd = open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (table.fd < 0)
+        return false;
+
+    // Without the lock another process could be halfway through creating the file
+    if (!lock_table(table, LOCK_EX))
+    {
+        close_high_score_table(table);
+        return false;
+    }
+
+    struct stat info;
+    bool ok = fstat(table.fd, &info) == 0;
+    bool fresh = ok && static_cast<size_t>(info.st_size) < HEADER_SIZE;
+    if (fresh)
+    {
+        ok = ftruncate(table.fd, HEADER_SIZE) == 0;
+    }
+
+    if (ok)
+    {
+        table.header = mmap(nullptr, HEADER_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, table.fd, 0);
+        ok = table.header != MAP_FAILED;
+        if (!ok)
+            table.header = nullptr;
+    }
+
+    if (ok)
+    {
+        table_header &header = header_of(table);
+        if (fresh || std::memcmp(header.magic, HIGH_SCORE_MAGIC, sizeof(HIGH_SCORE_MAGIC)) != 0)
+        {
+            // Only initialise files that hold no records yet, never clobber someone else's data
+            ok = fresh || record_count(table.fd) == 0;
+            if (ok)
+            {
+                std::memset(&header, 0, sizeof(header));
+                std::memcpy(header.magic, HIGH_SCORE_MAGIC, sizeof(HIGH_SCORE_MAGIC));
+                header.version = HIGH_SCORE_VERSION;
+                header.record_size = sizeof(high_score_record);
+                header.top_k = HIGH_SCORE_TOP_K;
+            }
+        }
+        ok = ok && header.version == HIGH_SCORE_VERSION &&
+             header.record_size == sizeof(high_score_record) &&
+             header.top_k == HIGH_SCORE_TOP_K &&
+             repair_index(table);
+    }
+
+    lock_table(table, LOCK_UN);
+
+    if (!ok)
+    {
+        close_high_score_table(table);
+    }
+    return ok;
+}
+
+void close_high_score_table(high_score_table &table)
+{
+    unmap_records(table);
+    if (table.header)
+    {
+        munmap(table.header, HEADER_SIZE);
+        table.header = nullptr;
+    }
+    if (table.fd >= 0)
+    {
+        close(table.fd);
+        table.fd = -1;
+    }
+}
+
+bool record_high_score(high_score_table &table, const string &name, int score, uint32_t ticks, uint64_t seed)
+{
+    if (!table.header)
+        return false;
+
+    high_score_record record = {};
+    record.timestamp = static_cast<int64_t>(std::time(nullptr));
+    record.seed = seed;
+    record.score = score;
+    record.ticks = ticks;
+    std::strncpy(record.name, name.c_str(), HIGH_SCORE_NAME_LENGTH - 1);
+    record.checksum = record_checksum(record);
+
+    if (!lock_table(table, LOCK_EX))
+        return false;
+
+    // Pick up records other processes appended, and overwrite any torn record at the end
+    bool ok = repair_index(table);
+    uint64_t index = record_count(table.fd);
+    off_t offset = static_cast<off_t>(HEADER_SIZE + index * sizeof(high_score_record));
+    ok = ok && pwrite(table.fd, &record, sizeof(record), offset) == static_cast<ssize_t>(sizeof(record));
+
+    if (ok)
+    {
+        // The record is in the file before the index points at it; a crash in between
+        // leaves indexed_count behind and the next open folds the record in
+        table_header &header = header_of(table);
+        heap_insert(header, record.score, index);
+        header.indexed_count = index + 1;
+        header.index_checksum = index_checksum(header);
+    }
+
+    lock_table(table, LOCK_UN);
+    return ok;
+}
+
+vector<high_score_record> top_high_scores(high_score_table &table, int count)
+{
+    vector<high_score_record> result;
+    if (!table.header)
+        return result;
+
+    if (!lock_table(table, LOCK_SH))
+        return result;
+
+    const table_header &header = header_of(table);
+    vector<heap_entry> entries(header.heap, header.heap + std::min<uint32_t>(header.heap_size, HIGH_SCORE_TOP_K));
+    std::sort(entries.begin(), entries.end(), [](const heap_entry &a, const heap_entry &b)
+              { return a.score != b.score ? a.score > b.score : a.record_index < b.record_index; });
+    entries.resize(std::min<size_t>(entries.size(), std::max(count, 0)));
+
+    const high_score_record *records = entries.empty() ? nullptr : map_records(table);
+    if (records)
+    {
+        uint64_t available = (table.mapping_size - HEADER_SIZE) / sizeof(high_score_record);
+        for (const heap_entry &entry : entries)
+        {
+            if (entry.record_index < available)
+            {
+                result.push_back(records[entry.record_index]);
+            }
+        }
+    }
+
+    lock_table(table, LOCK_UN);
+    return result;
+}
+
+uint64_t high_score_count(const high_score_table &table)
+{
+    return table.fd < 0 ? 0 : record_count(table.fd);
+}
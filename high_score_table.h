@@ -0,0 +1,99 @@
+#ifndef HIGH_SCORE_TABLE_H
+#define HIGH_SCORE_TABLE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+using std::string;
+using std::vector;
+
+// Number of best scores kept in the leaderboard index
+const int HIGH_SCORE_TOP_K = 100;
+const int HIGH_SCORE_NAME_LENGTH = 16;
+
+/**
+ * A single recorded game. Records are fixed size and are only ever
+ * appended, so the file can be shared by many processes.
+ *
+ * @field timestamp seconds since the epoch when the game ended
+ * @field seed      the seed the game was played with (see its replay)
+ * @field score     the final score
+ * @field ticks     how many ticks the game lasted
+ * @field name      the player name, zero padded
+ * @field checksum  checksum of the fields above, detects torn writes
+ */
+struct high_score_record
+{
+    int64_t timestamp;
+    uint64_t seed;
+    int32_t score;
+    uint32_t ticks;
+    char name[HIGH_SCORE_NAME_LENGTH];
+    uint32_t checksum;
+    uint32_t reserved;
+};
+
+/**
+ * An open high score file. The header page holding the top-K index is
+ * memory mapped for the lifetime of the table; the records themselves are
+ * mapped read only on demand.
+ *
+ * File layout: one header page (magic, counts, index checksum and a min-heap
+ * of the HIGH_SCORE_TOP_K best records) followed by the fixed size records.
+ * Appends are serialised between processes with an exclusive file lock.
+ */
+struct high_score_table
+{
+    int fd = -1;
+    void *header = nullptr;
+    void *mapping = nullptr;
+    size_t mapping_size = 0;
+};
+
+/**
+ * Open (creating if needed) a high score file. A damaged or stale index,
+ * e.g. after a crash mid update, is repaired from the records.
+ *
+ * @param table the table to open
+ * @param path  the file to use
+ * @returns true if the file could be opened
+ */
+bool open_high_score_table(high_score_table &table, const string &path);
+
+/**
+ * Unmap and close a high score file.
+ *
+ * @param table the table to close
+ */
+void close_high_score_table(high_score_table &table);
+
+/**
+ * Append a game to the file and update the top-K index.
+ *
+ * @param table the open table
+ * @param name  the player name (truncated to fit)
+ * @param score the final score
+ * @param ticks how many ticks the game lasted
+ * @param seed  the seed the game was played with
+ * @returns true if the record was written
+ */
+bool record_high_score(high_score_table &table, const string &name, int score, uint32_t ticks, uint64_t seed);
+
+/**
+ * Read the best scores from the index, without scanning the records.
+ *
+ * @param table the open table
+ * @param count how many scores to return (at most HIGH_SCORE_TOP_K)
+ * @returns the best records, highest score first
+ */
+vector<high_score_record> top_high_scores(high_score_table &table, int count);
+
+/**
+ * Count the complete records in the file.
+ *
+ * @param table the open table
+ * @returns the number of games recorded
+ */
+uint64_t high_score_count(const high_score_table &table);
+
+#endif
@@ -0,0 +1,176 @@
+#include "input_script.h"
+#include "splashkit.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+    struct input_state
+    {
+        input_mode mode = INPUT_CONSOLE;
+        std::FILE *recording = nullptr;
+        string script;
+        size_t next = 0;
+        size_t lines_read = 0;
+        bool ended = false;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    input_state &state()
+    {
+        // Never destroyed, so the exit handler can still use it
+        static input_state *input = new input_state();
+        return *input;
+    }
+
+    bool load_script(const char *path, string &script)
+    {
+        std::FILE *file = std::fopen(path, "rb");
+        if (!file)
+            return false;
+
+        char block[64 * 1024];
+        size_t got;
+        while ((got = std::fread(block, 1, sizeof(block), file)) > 0)
+        {
+            script.append(block, got);
+        }
+        std::fclose(file);
+        return true;
+    }
+
+    void report_replay()
+    {
+        input_state &input = state();
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - input.start).count();
+        std::cerr << "Replayed " << input.lines_read << " lines in " << ms << " ms" << std::endl;
+    }
+
+    void close_recording()
+    {
+        input_state &input = state();
+        if (input.recording)
+        {
+            std::fclose(input.recording);
+            input.recording = nullptr;
+        }
+    }
+
+    // The next line of the script, or false if there are none left
+    bool next_script_line(input_state &input, string &line)
+    {
+        if (input.next >= input.script.size())
+            return false;
+
+        size_t end = input.script.find('\n', input.next);
+        if (end == string::npos)
+            end = input.script.size();
+
+        size_t length = end - input.next;
+        if (length > 0 && input.script[end - 1] == '\r')
+            length--;
+
+        line.assign(input.script, input.next, length);
+        input.next = end + 1;
+        return true;
+    }
+}
+
+int use_input_script(int argc, char *argv[])
+{
+    input_state &input = state();
+    int kept = 1;
+
+    for (int i = 1; i < argc; i++)
+    {
+        bool record = std::strcmp(argv[i], "--record") == 0;
+        bool replay = std::strcmp(argv[i], "--replay") == 0;
+        if ((!record && !replay) || i + 1 >= argc)
+        {
+            argv[kept++] = argv[i];
+            continue;
+        }
+
+        const char *path = argv[++i];
+        if (record)
+        {
+            input.recording = std::fopen(path, "wb");
+            if (!input.recording)
+            {
+                std::cerr << "Could not create recording " << path << std::endl;
+                std::exit(1);
+            }
+            input.mode = INPUT_RECORD;
+            std::atexit(close_recording);
+        }
+        else
+        {
+            if (!load_script(path, input.script))
+            {
+                std::cerr << "Could not open recording " << path << std::endl;
+                std::exit(1);
+            }
+            input.mode = INPUT_REPLAY;
+            input.start = std::chrono::steady_clock::now();
+            std::atexit(report_replay);
+        }
+    }
+
+    argv[kept] = nullptr;
+    return kept;
+}
+
+input_mode current_input_mode()
+{
+    return state().mode;
+}
+
+string read_input_line(const string &prompt)
+{
+    input_state &input = state();
+    string line;
+
+    if (input.mode == INPUT_REPLAY)
+    {
+        if (next_script_line(input, line))
+        {
+            input.lines_read++;
+            return line;
+        }
+        if (input.ended)
+        {
+            std::cerr << "The recording ended before the program did" << std::endl;
+            std::exit(1);
+        }
+        input.ended = true;
+        return line;
+    }
+
+    if (!prompt.empty())
+    {
+        write(prompt);
+    }
+    line = read_line();
+    input.lines_read++;
+
+    if (input.recording && !(std::cin.eof() && line.empty()))
+    {
+        std::fwrite(line.data(), 1, line.size(), input.recording);
+        std::fputc('\n', input.recording);
+        // Flushed per line so the recording survives the program being killed
+        std::fflush(input.recording);
+    }
+    return line;
+}
+
+bool input_ended()
+{
+    input_state &input = state();
+    if (input.mode == INPUT_REPLAY)
+        return input.ended;
+    return std::cin.eof();
+}
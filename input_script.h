@@ -0,0 +1,60 @@
+#ifndef INPUT_SCRIPT_H
+#define INPUT_SCRIPT_H
+
+#include <string>
+using std::string;
+
+/**
+ * Where the program's input lines come from.
+ */
+enum input_mode
+{
+    INPUT_CONSOLE,
+    INPUT_RECORD,
+    INPUT_REPLAY
+};
+
+/**
+ * Take the input options out of the command line and set up the input.
+ *
+ *   --record <file>  read from the console as usual, saving every line
+ *   --replay <file>  read the lines of a recording instead of the console,
+ *                    without showing prompts, and report the time taken
+ *
+ * The options are removed from argv so the program's own option handling
+ * doesn't see them. If the file can't be opened, the program stops.
+ *
+ * @param argc number of command line arguments
+ * @param argv the arguments, with the input options removed on return
+ * @returns the number of arguments left
+ */
+int use_input_script(int argc, char *argv[]);
+
+/**
+ * Where input is coming from, as set up by use_input_script.
+ *
+ * @returns the input mode
+ */
+input_mode current_input_mode();
+
+/**
+ * Show a prompt and read a line of input. When recording, the line is
+ * saved; when replaying, the prompt is skipped and the next line of the
+ * recording returned. Reading past the end of a recording returns an empty
+ * line once, then stops the program, so a script that ends early can't
+ * leave a validation loop spinning.
+ *
+ * @param prompt the message to show the user, may be empty
+ * @returns the line, without its line ending
+ */
+string read_input_line(const string &prompt = "");
+
+/**
+ * Whether there is no more input: the console reached end of file or the
+ * recording being replayed ran out.
+ *
+ * @returns true once the input has ended
+ */
+bool input_ended();
+
+#endif
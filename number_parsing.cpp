@@ -0,0 +1,99 @@
+#include "number_parsing.h"
+
+#include <cctype>
+#include <charconv>
+#include <cmath>
+#include <cstdlib>
+
+namespace
+{
+    // Moves both ends inward past blanks, including the \r of Windows line endings
+    void trim(const char *&first, const char *&last)
+    {
+        while (first < last && std::isspace(static_cast<unsigned char>(*first)))
+            first++;
+        while (last > first && std::isspace(static_cast<unsigned char>(last[-1])))
+            last--;
+    }
+
+    // from_chars does not take a leading '+', but people type one
+    void skip_plus(const char *&first, const char *last)
+    {
+        if (last - first > 1 && *first == '+' && first[1] != '-' && first[1] != '+')
+            first++;
+    }
+
+    template <typename T>
+    parse_status convert(const char *first, const char *last, T &value)
+    {
+        trim(first, last);
+        if (first == last)
+            return PARSE_EMPTY;
+        skip_plus(first, last);
+
+        T result;
+        std::from_chars_result parsed = std::from_chars(first, last, result);
+        if (parsed.ec == std::errc::result_out_of_range && parsed.ptr == last)
+            return PARSE_OUT_OF_RANGE;
+        if (parsed.ec != std::errc() || parsed.ptr != last)
+            return PARSE_INVALID;
+
+        value = result;
+        return PARSE_OK;
+    }
+}
+
+parse_status parse_int(const char *first, const char *last, int &value)
+{
+    return convert(first, last, value);
+}
+
+parse_status parse_int(const string &text, int &value)
+{
+    return convert(text.data(), text.data() + text.size(), value);
+}
+
+parse_status parse_double(const char *first, const char *last, double &value)
+{
+    double result;
+    parse_status status = convert(first, last, result);
+    if (status == PARSE_OUT_OF_RANGE)
+    {
+        // from_chars treats underflow like overflow and gives no value. strtod rounds
+        // a number too close to zero to a subnormal or zero, which is what people
+        // expect of "1e-400"; only a number too large is out of range.
+        string text(first, last);
+        result = std::strtod(text.c_str(), nullptr);
+        if (std::isinf(result))
+            return PARSE_OUT_OF_RANGE;
+        status = PARSE_OK;
+    }
+    if (status != PARSE_OK)
+        return status;
+    if (!std::isfinite(result))
+        return PARSE_INVALID;
+
+    value = result;
+    return PARSE_OK;
+}
+
+parse_status parse_double(const string &text, double &value)
+{
+    return parse_double(text.data(), text.data() + text.size(), value);
+}
+
+const char *parse_status_message(parse_status status)
+{
+    switch (status)
+    {
+    case PARSE_OK:
+        return "OK";
+    case PARSE_EMPTY:
+        return "Please enter a number";
+    case PARSE_OUT_OF_RANGE:
+        return "That number is too large";
+    case PARSE_INVALID:
+    default:
+        return "That is not a valid number";
+    }
+}
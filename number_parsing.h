@@ -0,0 +1,69 @@
+#ifndef NUMBER_PARSING_H
+#define NUMBER_PARSING_H
+
+#include <string>
+using std::string;
+
+/**
+ * The outcome of parsing a number.
+ */
+enum parse_status
+{
+    PARSE_OK,
+    PARSE_EMPTY,
+    PARSE_INVALID,
+    PARSE_OUT_OF_RANGE
+};
+
+/**
+ * Parse text as a whole number. Blanks around the number and a leading
+ * '+' are allowed; anything else must be part of the number. The text is
+ * checked and converted in one pass, without exceptions or allocation.
+ *
+ * @param first start of the text
+ * @param last  end of the text
+ * @param value receives the number, left alone unless the result is PARSE_OK
+ * @returns whether the text was a number that fits in an int
+ */
+parse_status parse_int(const char *first, const char *last, int &value);
+
+/**
+ * Parse a string as a whole number, see parse_int above.
+ *
+ * @param text  the text
+ * @param value receives the number
+ * @returns whether the text was a number that fits in an int
+ */
+parse_status parse_int(const string &text, int &value);
+
+/**
+ * Parse text as a decimal number, e.g. "12", "-0.5" or "1e6". Blanks around
+ * the number and a leading '+' are allowed. Infinity and NaN are rejected,
+ * as are numbers too large for a double; numbers too close to zero round
+ * to a subnormal or zero, as with strtod.
+ *
+ * @param first start of the text
+ * @param last  end of the text
+ * @param value receives the number, left alone unless the result is PARSE_OK
+ * @returns whether the text was a finite number
+ */
+parse_status parse_double(const char *first, const char *last, double &value);
+
+/**
+ * Parse a string as a decimal number, see parse_double above.
+ *
+ * @param text  the text
+ * @param value receives the number
+ * @returns whether the text was a finite number
+ */
+parse_status parse_double(const string &text, double &value);
+
+/**
+ * A message to show the user when parsing failed.
+ *
+ * @param status the outcome of parsing
+ * @returns a short explanation
+ */
+const char *parse_status_message(parse_status status);
+
+#endif
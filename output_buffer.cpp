@@ -0,0 +1,100 @@
+#include "output_buffer.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+namespace
+{
+    void write_out(const char *data, size_t size)
+    {
+        std::fwrite(data, 1, size, stdout);
+    }
+
+    void flush_console()
+    {
+        flush_output(console_output());
+    }
+
+    // Double the text after start until it is length long
+    void double_until(string &text, size_t start, size_t length)
+    {
+        while (text.size() - start < length)
+        {
+            size_t have = text.size() - start;
+            text.append(text, start, std::min(have, length - have));
+        }
+    }
+}
+
+output_buffer &console_output()
+{
+    static output_buffer *console = nullptr;
+    if (!console)
+    {
+        // Never destroyed, so it can still be flushed by the exit handler
+        console = new output_buffer();
+        std::atexit(flush_console);
+    }
+    return *console;
+}
+
+void buffer_write(output_buffer &out, const string &text)
+{
+    out.text += text;
+    if (out.text.size() >= out.flush_size)
+    {
+        flush_output(out);
+    }
+}
+
+void buffer_write_line(output_buffer &out, const string &text)
+{
+    out.text += text;
+    out.text += '\n';
+    if (out.text.size() >= out.flush_size)
+    {
+        flush_output(out);
+    }
+}
+
+void buffer_repeat(output_buffer &out, const string &text, size_t count)
+{
+    if (text.empty() || count == 0)
+        return;
+
+    size_t length = text.size() * count;
+    if (out.text.size() + length <= out.flush_size)
+    {
+        size_t start = out.text.size();
+        out.text.reserve(start + length);
+        out.text += text;
+        double_until(out.text, start, length);
+        return;
+    }
+
+    // Too big to hold: build one chunk of whole copies and write it repeatedly
+    flush_output(out);
+    size_t per_chunk = std::max<size_t>(1, out.flush_size / text.size());
+    per_chunk = std::min(per_chunk, count);
+    string chunk = text;
+    chunk.reserve(per_chunk * text.size());
+    double_until(chunk, 0, per_chunk * text.size());
+
+    for (size_t written = 0; written < count; written += per_chunk)
+    {
+        size_t copies = std::min(per_chunk, count - written);
+        write_out(chunk.data(), copies * text.size());
+    }
+    std::fflush(stdout);
+}
+
+void flush_output(output_buffer &out)
+{
+    if (!out.text.empty())
+    {
+        write_out(out.text.data(), out.text.size());
+        out.text.clear();
+    }
+    std::fflush(stdout);
+}
@@ -0,0 +1,66 @@
+#ifndef OUTPUT_BUFFER_H
+#define OUTPUT_BUFFER_H
+
+#include <cstddef>
+#include <string>
+using std::string;
+
+// Buffered text is written out once it reaches this size
+const size_t OUTPUT_FLUSH_SIZE = 64 * 1024;
+
+/**
+ * Console text waiting to be written. Building output here and writing it
+ * in large chunks replaces a write (and, for write_line, a flush) per call.
+ *
+ * @field text       the text not yet written
+ * @field flush_size how much text to gather before writing it
+ */
+struct output_buffer
+{
+    string text;
+    size_t flush_size = OUTPUT_FLUSH_SIZE;
+};
+
+/**
+ * The shared buffer for standard output. It is flushed when the program
+ * exits; flush it yourself before waiting for input.
+ *
+ * @returns the buffer
+ */
+output_buffer &console_output();
+
+/**
+ * Add text to a buffer.
+ *
+ * @param out  the buffer
+ * @param text the text
+ */
+void buffer_write(output_buffer &out, const string &text);
+
+/**
+ * Add text and a new line to a buffer.
+ *
+ * @param out  the buffer
+ * @param text the text
+ */
+void buffer_write_line(output_buffer &out, const string &text = "");
+
+/**
+ * Add text to a buffer a number of times. The copies are made by doubling
+ * what is already there, so the work is a few large copies rather than
+ * one small one per repetition.
+ *
+ * @param out   the buffer
+ * @param text  the text to repeat
+ * @param count how many times
+ */
+void buffer_repeat(output_buffer &out, const string &text, size_t count);
+
+/**
+ * Write out everything in a buffer to standard output.
+ *
+ * @param out the buffer
+ */
+void flush_output(output_buffer &out);
+
+#endif
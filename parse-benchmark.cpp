@@ -0,0 +1,168 @@
+#include "splashkit.h"
+#include "number_parsing.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * Compares the shared parsing functions with the ways the programs used to
+ * read numbers, on a mix of the input people actually type.
+ *
+ * Usage: parse-benchmark [rounds]
+ */
+
+/**
+ * The input to parse: mostly valid numbers, with typos, blanks and values
+ * too large to fit, the cases that made the old paths take exceptions
+ *
+ * @return The inputs
+ */
+std::vector<string> benchmark_inputs()
+{
+    return {"0", "7", "42", "-13", "2024", "123456", "99999", "-1",
+            "3.5", "-0.25", "1e3", "12abc", "", "abc", " 8", "+9",
+            "99999999999", "1e999", "100.00", "65"};
+}
+
+/**
+ * The old utilities read_integer check: SplashKit's is_integer, then stoi
+ *
+ * @param text  The text to parse
+ * @param value Receives the number
+ * @return      True if the text was accepted
+ */
+bool old_utilities_integer(const string &text, int &value)
+{
+    if (!is_integer(text))
+        return false;
+    try
+    {
+        value = std::stoi(text);
+        return true;
+    }
+    catch (const std::out_of_range &)
+    {
+        return false;
+    }
+}
+
+/**
+ * The old AFLscore check: digits only, then stoi catching out_of_range
+ *
+ * @param text  The text to parse
+ * @param value Receives the number
+ * @return      True if the text was accepted
+ */
+bool old_afl_integer(const string &text, int &value)
+{
+    if (text.empty() || !std::all_of(text.begin(), text.end(), ::isdigit))
+        return false;
+    try
+    {
+        value = std::stoi(text);
+        return true;
+    }
+    catch (const std::out_of_range &)
+    {
+        return false;
+    }
+}
+
+/**
+ * The old SimpleStats check: stod, catching invalid input
+ *
+ * @param text  The text to parse
+ * @param value Receives the number
+ * @return      True if the text was accepted
+ */
+bool old_stats_double(const string &text, double &value)
+{
+    try
+    {
+        value = std::stod(text);
+        return true;
+    }
+    catch (const std::exception &)
+    {
+        return false;
+    }
+}
+
+/**
+ * The old bank-system check: SplashKit's is_number, then convert_to_double
+ *
+ * @param text  The text to parse
+ * @param value Receives the number
+ * @return      True if the text was accepted
+ */
+bool old_bank_double(const string &text, double &value)
+{
+    if (!is_number(text))
+        return false;
+    value = convert_to_double(text);
+    return true;
+}
+
+/**
+ * Times a parser over every input, many times
+ *
+ * @param name   What to call it in the results
+ * @param inputs The text to parse
+ * @param rounds How many times to parse all of it
+ * @param parse  The parser, returning true if the text was accepted
+ */
+template <typename Parser>
+void time_parser(const string &name, const std::vector<string> &inputs, int rounds, Parser parse)
+{
+    long accepted = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < rounds; round++)
+    {
+        for (const string &input : inputs)
+        {
+            accepted += parse(input);
+        }
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    string label = name;
+    label.resize(37, ' ');
+    write_line(label + std::to_string(ns / (static_cast<double>(rounds) * inputs.size())) + " ns/parse, " +
+               std::to_string(accepted / rounds) + " of " + std::to_string(inputs.size()) + " accepted");
+}
+
+int main(int argc, char *argv[])
+{
+    int rounds = 200000;
+    if (argc > 1 && (parse_int(string(argv[1]), rounds) != PARSE_OK || rounds < 1))
+    {
+        write_line("Usage: parse-benchmark [rounds]");
+        return 1;
+    }
+
+    std::vector<string> inputs = benchmark_inputs();
+    int int_value = 0;
+    double double_value = 0;
+
+    write_line("Whole numbers:");
+    time_parser("  is_integer + stoi (utilities)", inputs, rounds, [&](const string &text)
+                { return old_utilities_integer(text, int_value); });
+    time_parser("  digits + stoi (AFLscore)", inputs, rounds, [&](const string &text)
+                { return old_afl_integer(text, int_value); });
+    time_parser("  parse_int", inputs, rounds, [&](const string &text)
+                { return parse_int(text, int_value) == PARSE_OK; });
+
+    write_line("Decimal numbers:");
+    time_parser("  stod + exceptions (SimpleStats)", inputs, rounds, [&](const string &text)
+                { return old_stats_double(text, double_value); });
+    time_parser("  is_number + convert (bank-system)", inputs, rounds, [&](const string &text)
+                { return old_bank_double(text, double_value); });
+    time_parser("  parse_double", inputs, rounds, [&](const string &text)
+                { return parse_double(text, double_value) == PARSE_OK; });
+
+    return 0;
+}
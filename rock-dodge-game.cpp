@@ -1,18 +1,50 @@
 #include "splashkit.h"
+#include "asset_pack.h"
+#include "frame_profiler.h"
 #include <iostream>
 #include <random>
 #include <ctime>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <cmath>
+#include <cstdint>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <fstream>
+
+// The rock kernel uses AVX2 when compiled with -mavx2 (or -march=native), scalar code otherwise
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
 // Constants
+const int SIMULATION_RATE = 60;   // Fixed simulation ticks per second, speeds are per tick
+const int TARGET_FRAME_RATE = 60; // Frames drawn per second
+const std::chrono::nanoseconds TICK_DURATION(1000000000LL / SIMULATION_RATE);
+const std::chrono::nanoseconds FRAME_DURATION(1000000000LL / TARGET_FRAME_RATE);
+const std::chrono::nanoseconds MAX_CATCH_UP(250000000LL); // Longest stall the simulation catches up on
+const long long DEFAULT_HEADLESS_TICKS = 60LL * SIMULATION_RATE; // Headless games stop after a simulated minute
 const int SCREEN_WIDTH = 800;
 const int SCREEN_HEIGHT = 600;
 const int PLAYER_SIZE = 30;
-const int MAX_ROCKS = 100;
 const int PLAYER_SPEED = 5;
 const int INITIAL_LIVES = 3;
+const float MIN_ROCK_SIZE = 20.0f;
+const float MAX_ROCK_SIZE = 200.0f;
+const float GRID_CELL_SIZE = MAX_ROCK_SIZE / 2; // Broadphase cell size, the largest rock radius
+const uint8_t ROCK_OFF_SCREEN = 1; // Rock flag: fell past the bottom of the screen
+const uint8_t ROCK_HIT_PLAYER = 2; // Rock flag: overlaps the player
 const string BACKGROUND_MUSIC = "boss_music";
 const string ROCK_BITMAP = "rock_image";
 const string PLAYER_BITMAP = "player_image";
+const string ASSET_PACK_FILE = "rock-dodge.pack"; // Saved by the game on first launch, or by asset-pack-builder
+const double PLAYER_SCALE = 0.3;        // The player bitmap is drawn at this scale...
+const double PLAYER_VERTICAL_OFFSET = 90; // ...and this far above the player position
+const uint8_t MASK_ALPHA_THRESHOLD = 128; // Pixels at least this opaque are solid for collision
 
 /**
  * Structure to represent a rock in the game
@@ -28,65 +60,384 @@ struct rock_data
     float speed;
 };
 
+/**
+ * Pool of all rocks stored as a structure of arrays. Each property lives in
+ * its own contiguous array so the update loop streams through memory, and a
+ * rock is removed in O(1) by moving the last rock into its slot.
+ *
+ * @field x     Horizontal centre of each rock
+ * @field y     Vertical centre of each rock
+ * @field size  Size (diameter) of each rock
+ * @field speed How fast each rock falls down the screen
+ */
+struct rock_pool
+{
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> size;
+    std::vector<float> speed;
+};
+
+/**
+ * Uniform grid used as the collision broadphase. Rocks are bucketed by the
+ * cell holding their centre with a counting sort, so each cell's rocks are
+ * a contiguous run of rock_index. A query only visits the cells its circle
+ * (grown by the largest rock radius) overlaps.
+ *
+ * @field columns    Number of cell columns
+ * @field rows       Number of cell rows
+ * @field origin_y   Y coordinate of the top of the grid (rocks spawn above the screen)
+ * @field cell_start Offset of each cell's run in rock_index, plus a spare cell and an end offset
+ * @field rock_index Rock indices sorted by cell
+ * @field rock_cell  Cell of each rock, scratch space for the build
+ */
+struct spatial_grid
+{
+    int columns;
+    int rows;
+    float origin_y;
+    std::vector<int> cell_start;
+    std::vector<int> rock_index;
+    std::vector<int> rock_cell;
+};
+
+/**
+ * The solid pixels of a sprite drawn at one size, one bit per pixel. Each
+ * row is padded with zero bits to whole 64-bit words, so two masks can be
+ * compared a word at a time.
+ *
+ * @field width         Width in pixels
+ * @field height        Height in pixels
+ * @field words_per_row 64-bit words in each row
+ * @field bits          The rows, top to bottom, bit 0 of a word is its leftmost pixel
+ */
+struct collision_mask
+{
+    int width;
+    int height;
+    int words_per_row;
+    std::vector<uint64_t> bits;
+};
+
+/**
+ * Collision masks for every size the sprites are drawn at, built once
+ * when the game loads. Rocks are drawn at any size from MIN_ROCK_SIZE to
+ * MAX_ROCK_SIZE, so there is a mask for each whole pixel size in between.
+ *
+ * @field rock         Rock masks, indexed by rounded size - MIN_ROCK_SIZE
+ * @field player       The player mask at PLAYER_SCALE
+ * @field query_radius Broadphase radius around the player sprite's centre
+ *                     that finds every rock whose sprite can overlap it
+ */
+struct collision_masks
+{
+    std::vector<collision_mask> rock;
+    collision_mask player;
+    float query_radius;
+};
+
+/**
+ * Bitmaps resolved once at load time with their dimensions, so drawing a
+ * frame never looks a bitmap up by name or asks for its size
+ *
+ * @field rock          The rock bitmap
+ * @field player        The player bitmap
+ * @field rock_width    Width of the rock bitmap in pixels
+ * @field rock_height   Height of the rock bitmap in pixels
+ * @field player_width  Width of the player bitmap in pixels
+ * @field player_height Height of the player bitmap in pixels
+ */
+struct game_assets
+{
+    bitmap rock;
+    bitmap player;
+    double rock_width;
+    double rock_height;
+    double player_width;
+    double player_height;
+};
+
+/**
+ * Kinds of asset the game loads
+ */
+enum asset_kind
+{
+    BITMAP_ASSET,
+    MUSIC_ASSET
+};
+
+/**
+ * An asset being loaded. Its file is read on a background thread, then the
+ * SplashKit resource is created on the main thread, since SplashKit must
+ * only be called from there.
+ *
+ * @field kind      Whether the asset is a bitmap or music
+ * @field name      Name the asset is loaded under
+ * @field path      File to load it from
+ * @field file_read Completes once the file has been read into memory
+ * @field loaded    True once the SplashKit resource exists
+ */
+struct pending_asset
+{
+    asset_kind kind;
+    std::string name;
+    std::string path;
+    std::future<bool> file_read;
+    bool loaded;
+};
+
+/**
+ * Where to draw each of a number of sprites that share one bitmap. The
+ * placements are worked out in one pass over the game state, then drawn
+ * with one draw_bitmap each, as SplashKit has no call to draw many at once.
+ *
+ * @field bmp   The bitmap every sprite in the list uses
+ * @field x     Left edge of each sprite
+ * @field y     Top edge of each sprite
+ * @field scale Scale of each sprite
+ */
+struct sprite_list
+{
+    bitmap bmp;
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> scale;
+};
+
+/**
+ * The player's input, sampled once per frame and applied every tick
+ *
+ * @field left  Move left is held
+ * @field right Move right is held
+ */
+struct player_input
+{
+    bool left;
+    bool right;
+};
+
+/**
+ * The game's random generator (splitmix64). Numbers are made from its
+ * output directly rather than through the standard distributions, whose
+ * results differ between standard libraries, so a seed plays the same game
+ * whichever toolchain built it.
+ *
+ * @field state The whole state of the generator
+ */
+struct game_rng
+{
+    uint64_t state;
+};
+
+/**
+ * Frame timing for a whole session
+ *
+ * @field frame_ms       Duration of every frame, start to start
+ * @field latency_ms     For every frame, how old the input it shows was when it reached the screen
+ * @field dropped_frames Frames that took over 1.5x the target frame time
+ * @field ticks          Simulation ticks run
+ */
+struct frame_stats
+{
+    std::vector<float> frame_ms;
+    std::vector<float> latency_ms;
+    int dropped_frames = 0;
+    long long ticks = 0;
+};
+
 /**
  * Structure to hold all game data
  *
- * @field rocks           Array of all rocks in the game (maximum MAX_ROCKS)
- * @field num_rocks       Current number of rocks in the array
+ * @field rocks           Pool of all rocks in the game
+ * @field grid            Collision broadphase, rebuilt from rocks every frame
+ * @field masks           Sprite collision masks, or nullptr to collide rocks and player as circles
+ * @field zones           Where update and collision are timed, or nullptr when not profiling
+ * @field rock_flags      Per-rock ROCK_OFF_SCREEN/ROCK_HIT_PLAYER flags for this frame
+ * @field candidates      Scratch list of broadphase candidates, reused every tick
+ * @field hits            Scratch list of narrowphase hits, reused every tick
  * @field player_position Position of the player on screen
- * @field next_rock_time  Time (in ms) when the next rock should appear
+ * @field previous_player_position Position of the player before the last tick, for interpolation
+ * @field rng             The game's only random generator, seeded explicitly so runs can be reproduced
+ * @field tick            Number of simulation ticks run, the game's clock
+ * @field next_rock_tick  Tick when the next rock should appear
  * @field score           Current player score
  * @field lives           Number of lives remaining
- * @field quit            Flag to indicate if the game should exit
  */
 struct game_data
 {
-    rock_data rocks[MAX_ROCKS];
-    int num_rocks;
+    rock_pool rocks;
+    spatial_grid grid;
+    const collision_masks *masks;
+    zone_times *zones;
+    std::vector<uint8_t> rock_flags;
+    std::vector<int> candidates;
+    std::vector<int> hits;
+    point_2d player_position;
+    point_2d previous_player_position;
+    game_rng rng;
+    long long tick;
+    long long next_rock_tick;
+    int score;
+    int lives;
+};
+
+/**
+ * Everything draw_game needs from the simulation, copied out once per
+ * frame so the simulation can move on while the copy is drawn
+ *
+ * @field rocks           The rocks after the frame's last tick
+ * @field player_position Position of the player after the last tick
+ * @field previous_player_position Position of the player before the last tick
+ * @field score           Player score
+ * @field lives           Lives remaining
+ * @field tick            Simulation ticks run
+ * @field alpha           How far to draw between the last two ticks, 0 to 1
+ * @field input_time      When the input for the last tick was sampled
+ * @field zones           Update and collision times of the ticks behind this snapshot
+ */
+struct render_snapshot
+{
+    rock_pool rocks;
     point_2d player_position;
-    unsigned int next_rock_time;
+    point_2d previous_player_position;
     int score;
     int lives;
-    bool quit;
+    long long tick;
+    float alpha;
+    std::chrono::steady_clock::time_point input_time;
+    zone_times zones;
+};
+
+/**
+ * One frame's worth of simulation, handed from the main thread to the
+ * simulation thread
+ *
+ * @field input      The input sampled this frame
+ * @field ticks      How many ticks the elapsed time covers
+ * @field alpha      How far the frame falls between the last two ticks
+ * @field input_time When the input was sampled
+ * @field profile    Whether to time the ticks
+ */
+struct simulation_job
+{
+    player_input input;
+    int ticks;
+    float alpha;
+    std::chrono::steady_clock::time_point input_time;
+    bool profile;
+};
+
+/**
+ * Hand off between the main thread, which handles input and draws, and
+ * the simulation thread. While the main thread draws frame N from its
+ * snapshot, the simulation thread runs frame N+1 into back; the two
+ * snapshots are swapped once both are done. Only the simulation thread
+ * touches game_data while it is running.
+ *
+ * @field lock     Guards every other field
+ * @field changed  Signalled when a job is posted, finished or stop is set
+ * @field job      The frame to simulate next
+ * @field job_ready True while a job is waiting for the simulation thread
+ * @field job_done True once the simulation thread has filled back
+ * @field stop     Tells the simulation thread to exit
+ * @field back     The snapshot the simulation thread writes
+ */
+struct frame_pipeline
+{
+    std::mutex lock;
+    std::condition_variable changed;
+    simulation_job job;
+    bool job_ready = false;
+    bool job_done = false;
+    bool stop = false;
+    render_snapshot back;
 };
 
 /**
- * Checks if two circles are colliding
+ * Draws the next 64 random bits
  *
- * @param a The first circle
- * @param b The second circle
- * @return  True if the circles are colliding, false otherwise
+ * @param rng The generator
+ * @return    The bits
  */
-bool check_collision(circle a, circle b)
+uint64_t next_random(game_rng &rng)
 {
-    float dx = center_point(a).x - center_point(b).x;
-    float dy = center_point(a).y - center_point(b).y;
-    float distance = sqrt(dx * dx + dy * dy);
-    return distance < (circle_radius(a) + circle_radius(b));
+    uint64_t z = (rng.state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
 }
 
 /**
- * Creates a new rock with random properties
+ * Draws a random float in [min, max), from the top 24 bits so every value
+ * is exact in a float before it is scaled
  *
- * @return A new rock with random size, position and speed
+ * @param rng The generator
+ * @param min Lowest value
+ * @param max Highest value, not included
+ * @return    The random value
  */
-rock_data create_rock()
+float random_float(game_rng &rng, float min, float max)
 {
-    static std::random_device rd;
-    static std::mt19937 gen(rd());
+    float fraction = static_cast<float>(next_random(rng) >> 40) * (1.0f / 16777216.0f);
+    return min + (max - min) * fraction;
+}
 
-    std::uniform_real_distribution<float> size_dist(20.0f, 200.0f);
-    std::uniform_real_distribution<float> pos_dist(0.0f, static_cast<float>(SCREEN_WIDTH));
-    std::uniform_real_distribution<float> speed_dist(15.0f, 25.0f); // Bookmark: set speed here <----
+/**
+ * Draws a random integer in [min, max] by scaling the top 32 bits, which
+ * is unbiased enough for ranges this small
+ *
+ * @param rng The generator
+ * @param min Lowest value
+ * @param max Highest value, included
+ * @return    The random value
+ */
+int random_int(game_rng &rng, int min, int max)
+{
+    uint64_t range = static_cast<uint64_t>(max - min) + 1;
+    return min + static_cast<int>(((next_random(rng) >> 32) * range) >> 32);
+}
 
+/**
+ * Creates a new rock with random properties
+ *
+ * @param rng The random generator to draw from
+ * @return    A new rock with random size, position and speed
+ */
+rock_data create_rock(game_rng &rng)
+{
     rock_data rock;
-    rock.size = size_dist(gen);
-    rock.position = point_at(pos_dist(gen), -rock.size);
-    rock.speed = speed_dist(gen);
+    rock.size = random_float(rng, MIN_ROCK_SIZE, MAX_ROCK_SIZE);
+    rock.position = point_at(random_float(rng, 0.0f, static_cast<float>(SCREEN_WIDTH)), -rock.size);
+    rock.speed = random_float(rng, 15.0f, 25.0f); // Bookmark: set speed here <----
 
     return rock;
 }
 
+/**
+ * Gets the number of rocks in a pool
+ *
+ * @param rocks The rock pool
+ * @return      The number of rocks
+ */
+int rock_count(const rock_pool &rocks)
+{
+    return static_cast<int>(rocks.x.size());
+}
+
+/**
+ * Appends a rock to the end of a pool
+ *
+ * @param rocks The rock pool to add to
+ * @param rock  The rock to add
+ */
+void push_rock(rock_pool &rocks, const rock_data &rock)
+{
+    rocks.x.push_back(static_cast<float>(rock.position.x));
+    rocks.y.push_back(static_cast<float>(rock.position.y));
+    rocks.size.push_back(rock.size);
+    rocks.speed.push_back(rock.speed);
+}
+
 /**
  * Adds a new rock to the game
  *
@@ -94,225 +445,1537 @@ rock_data create_rock()
  */
 void add_rock(game_data &game)
 {
-    if (game.num_rocks < MAX_ROCKS)
-    {
-        game.rocks[game.num_rocks] = create_rock();
-        game.num_rocks++;
-        game.score++;
-    }
+    push_rock(game.rocks, create_rock(game.rng));
+    game.score++;
 }
 
 /**
- * Removes a rock from the game by its index
+ * Sizes the broadphase grid to cover the screen plus the band above and
+ * below it where rocks enter and leave
  *
- * @param game  The game data to remove the rock from
- * @param index The index of the rock to remove
+ * @param grid The grid to initialize
  */
-void remove_rock(game_data &game, int index)
+void init_grid(spatial_grid &grid)
 {
-    if (index >= 0 && index < game.num_rocks)
-    {
+    grid.columns = static_cast<int>(std::ceil(SCREEN_WIDTH / GRID_CELL_SIZE));
+    grid.rows = static_cast<int>(std::ceil((SCREEN_HEIGHT + 2 * MAX_ROCK_SIZE) / GRID_CELL_SIZE));
+    grid.origin_y = -MAX_ROCK_SIZE;
+}
 
-        for (int i = index; i < game.num_rocks - 1; i++)
-        {
-            game.rocks[i] = game.rocks[i + 1];
-        }
-        game.num_rocks--;
-    }
+/**
+ * Gets the grid column holding an x coordinate, clamped to the grid.
+ * Clamping before the conversion keeps the value non-negative, so
+ * truncation rounds down; the same sum is used when building the grid.
+ */
+int grid_column(const spatial_grid &grid, float x)
+{
+    return static_cast<int>(std::min(std::max(x * (1.0f / GRID_CELL_SIZE), 0.0f), grid.columns - 1.0f));
 }
 
 /**
- * Initializes the game data to start a new game
- *
- * @param game The game data to initialize
+ * Gets the grid row holding a y coordinate, clamped to the grid
  */
-void init_game(game_data &game)
+int grid_row(const spatial_grid &grid, float y)
 {
-    game.player_position = point_at(SCREEN_WIDTH / 2.0f, SCREEN_HEIGHT - PLAYER_SIZE * 2);
-    game.next_rock_time = current_ticks() + 1000;
-    game.score = 0;
-    game.lives = INITIAL_LIVES;
-    game.quit = false;
-    game.num_rocks = 0; // Start with no rocks
+    return static_cast<int>(std::min(std::max((y - grid.origin_y) * (1.0f / GRID_CELL_SIZE), 0.0f), grid.rows - 1.0f));
 }
 
 /**
- * Updates the game state for one frame
+ * Buckets every rock into the grid cell holding its centre using a
+ * counting sort, O(n) with no per-cell allocations
  *
- * @param game The game data to update
+ * @param grid  The grid to rebuild
+ * @param rocks The rocks to bucket
+ * @param flags Rocks with any flag set are about to be removed and are left out
  */
-void update_game(game_data &game)
+void build_grid(spatial_grid &grid, const rock_pool &rocks, const std::vector<uint8_t> &flags)
 {
-    unsigned int current_time = current_ticks();
-    if (current_time >= game.next_rock_time && game.num_rocks < MAX_ROCKS)
-    {
-        add_rock(game);
+    int num_rocks = rock_count(rocks);
+    int num_cells = grid.columns * grid.rows;
 
-        static std::random_device rd;
-        static std::mt19937 gen(rd());
-        std::uniform_int_distribution<unsigned int> time_dist(1000, 2000); // <-- made the game a bit harder
-        game.next_rock_time = current_time + time_dist(gen);
+    // One spare cell past the end collects the flagged rocks, queries never visit it
+    grid.cell_start.assign(num_cells + 2, 0);
+    grid.rock_cell.resize(num_rocks);
+    grid.rock_index.resize(num_rocks);
+
+    // Work out each rock's cell, a branch free loop the compiler can vectorise
+    int *rock_cell = grid.rock_cell.data();
+    for (int i = 0; i < num_rocks; i++)
+    {
+        int cell = grid_row(grid, rocks.y[i]) * grid.columns + grid_column(grid, rocks.x[i]);
+        rock_cell[i] = flags[i] ? num_cells : cell;
     }
 
-    // Update all rocks
-    for (int i = 0; i < game.num_rocks; i++)
+    // Count the rocks in each cell
+    for (int i = 0; i < num_rocks; i++)
     {
-        // Update rock position
-        game.rocks[i].position.y += game.rocks[i].speed;
+        grid.cell_start[rock_cell[i] + 1]++;
+    }
 
-        // Check if rock is off the screen
-        if (game.rocks[i].position.y - game.rocks[i].size > SCREEN_HEIGHT)
-        {
-            game.score += static_cast<int>(game.rocks[i].size); // Add rock size to score
-            remove_rock(game, i);                               // Remove rock
-            i--;                                                // Adjust index after removal
-            continue;
-        }
+    // Turn the counts into start offsets
+    for (int cell = 0; cell <= num_cells; cell++)
+    {
+        grid.cell_start[cell + 1] += grid.cell_start[cell];
+    }
 
-        // Check collision with player
-        circle rock_circle = circle_at(game.rocks[i].position.x, game.rocks[i].position.y, game.rocks[i].size / 2.0f);
-        circle player_circle = circle_at(game.player_position.x, game.player_position.y, PLAYER_SIZE / 2.0f);
+    // Scatter the rocks, advancing each cell's start to its end as we go...
+    for (int i = 0; i < num_rocks; i++)
+    {
+        grid.rock_index[grid.cell_start[rock_cell[i]]++] = i;
+    }
 
-        if (check_collision(rock_circle, player_circle))
-        {
-            game.lives--;         // Lose a life
-            remove_rock(game, i); // Remove the rock
-            i--;                  // Adjust index after removal
-        }
+    // ...then shift the offsets back so cell_start[c] is the start of cell c again
+    for (int cell = num_cells + 1; cell > 0; cell--)
+    {
+        grid.cell_start[cell] = grid.cell_start[cell - 1];
     }
+    grid.cell_start[0] = 0;
 }
 
 /**
- * Handles user input for one frame
+ * Collects the rocks that may overlap a circle. Any rock overlapping the
+ * circle has its centre within the circle's radius plus the largest rock
+ * radius, so only those cells are visited.
  *
- * @param game The game data to update based on input
+ * @param grid       The grid built for this frame
+ * @param x          Circle centre x
+ * @param y          Circle centre y
+ * @param radius     Circle radius
+ * @param candidates Receives the candidate rock indices
  */
-void handle_input(game_data &game)
+void query_grid(const spatial_grid &grid, float x, float y, float radius, std::vector<int> &candidates)
 {
-    process_events();
+    float reach = radius + MAX_ROCK_SIZE / 2;
+    int first_column = grid_column(grid, x - reach);
+    int last_column = grid_column(grid, x + reach);
+    int first_row = grid_row(grid, y - reach);
+    int last_row = grid_row(grid, y + reach);
 
-    if (quit_requested())
+    candidates.clear();
+    for (int row = first_row; row <= last_row; row++)
     {
-        game.quit = true;
+        // The cells of one row are adjacent, so their rocks form one run
+        int begin = grid.cell_start[row * grid.columns + first_column];
+        int end = grid.cell_start[row * grid.columns + last_column + 1];
+        candidates.insert(candidates.end(), grid.rock_index.begin() + begin, grid.rock_index.begin() + end);
     }
+}
 
-    // Handle keyboard input for player movement
-    if (key_down(LEFT_KEY) || key_down(A_KEY))
+/**
+ * Tests a circle against a batch of candidate rocks, comparing squared
+ * distances so no square root is needed
+ *
+ * @param rocks      The rock pool
+ * @param candidates Indices of the rocks to test
+ * @param x          Circle centre x
+ * @param y          Circle centre y
+ * @param radius     Circle radius
+ * @param hits       Receives the indices of the rocks overlapping the circle
+ */
+void collide_circle(const rock_pool &rocks, const std::vector<int> &candidates,
+                    float x, float y, float radius, std::vector<int> &hits)
+{
+    const float *rock_x = rocks.x.data();
+    const float *rock_y = rocks.y.data();
+    const float *rock_size = rocks.size.data();
+
+    int num_candidates = static_cast<int>(candidates.size());
+    int c = 0;
+
+    hits.clear();
+
+#if defined(__AVX2__)
+    // Gather eight candidates at a time and test them together
+    const __m256 circle_x = _mm256_set1_ps(x);
+    const __m256 circle_y = _mm256_set1_ps(y);
+    const __m256 circle_radius = _mm256_set1_ps(radius);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    for (; c + 8 <= num_candidates; c += 8)
     {
-        game.player_position.x -= PLAYER_SPEED;
-        if (game.player_position.x < PLAYER_SIZE / 2.0f)
+        __m256i index = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(candidates.data() + c));
+        __m256 dx = _mm256_sub_ps(_mm256_i32gather_ps(rock_x, index, 4), circle_x);
+        __m256 dy = _mm256_sub_ps(_mm256_i32gather_ps(rock_y, index, 4), circle_y);
+        __m256 reach = _mm256_add_ps(_mm256_mul_ps(_mm256_i32gather_ps(rock_size, index, 4), half), circle_radius);
+        __m256 distance_squared = _mm256_add_ps(_mm256_mul_ps(dx, dx), _mm256_mul_ps(dy, dy));
+        int mask = _mm256_movemask_ps(_mm256_cmp_ps(distance_squared, _mm256_mul_ps(reach, reach), _CMP_LT_OQ));
+        while (mask)
         {
-            game.player_position.x = PLAYER_SIZE / 2.0f;
+            int lane = __builtin_ctz(mask);
+            hits.push_back(candidates[c + lane]);
+            mask &= mask - 1;
         }
     }
-    if (key_down(RIGHT_KEY) || key_down(D_KEY))
+#endif
+
+    for (; c < num_candidates; c++)
     {
-        game.player_position.x += PLAYER_SPEED;
-        if (game.player_position.x > SCREEN_WIDTH - PLAYER_SIZE / 2.0f)
+        int index = candidates[c];
+        float dx = rock_x[index] - x;
+        float dy = rock_y[index] - y;
+        float reach = rock_size[index] * 0.5f + radius;
+        if (dx * dx + dy * dy < reach * reach)
         {
-            game.player_position.x = SCREEN_WIDTH - PLAYER_SIZE / 2.0f;
+            hits.push_back(index);
         }
     }
 }
 
 /**
- * Draws the current game state to the screen
+ * Builds the collision mask of a sprite drawn at a given size, sampling
+ * its pixels nearest neighbour as the scaled bitmap is drawn
  *
- * @param game The game data to draw
+ * @param pixels The sprite's pixels
+ * @param width  Drawn width in pixels
+ * @param height Drawn height in pixels
+ * @return       The mask
  */
-void draw_game(const game_data &game)
+collision_mask build_mask(const pixel_view &pixels, int width, int height)
 {
-    clear_screen(COLOR_BLACK);
+    collision_mask mask;
+    mask.width = std::max(width, 1);
+    mask.height = std::max(height, 1);
+    mask.words_per_row = (mask.width + 63) / 64;
+    mask.bits.assign(static_cast<size_t>(mask.words_per_row) * mask.height, 0);
 
-    bitmap player_bmp = bitmap_named(PLAYER_BITMAP);
+    for (int y = 0; y < mask.height; y++)
+    {
+        int source_y = (2 * y + 1) * pixels.height / (2 * mask.height);
+        const uint8_t *source_row = pixels.pixels + static_cast<size_t>(source_y) * pixels.width * 4;
+        uint64_t *row = mask.bits.data() + static_cast<size_t>(y) * mask.words_per_row;
+        for (int x = 0; x < mask.width; x++)
+        {
+            int source_x = (2 * x + 1) * pixels.width / (2 * mask.width);
+            if (source_row[source_x * 4 + 3] >= MASK_ALPHA_THRESHOLD)
+            {
+                row[x / 64] |= uint64_t(1) << (x % 64);
+            }
+        }
+    }
+    return mask;
+}
 
-    // Player bitmap
-    double player_scale = 0.3;
-    int vertical_offset = 90;
-    draw_bitmap(PLAYER_BITMAP,
-                game.player_position.x - (bitmap_width(player_bmp) * player_scale) / 2,
-                game.player_position.y - (bitmap_height(player_bmp) * player_scale) / 2 - vertical_offset,
-                option_scale_bmp(player_scale, player_scale));
+/**
+ * Builds the masks for every rock size and for the player
+ *
+ * @param masks  The masks to fill in
+ * @param rock   The rock sprite's pixels
+ * @param player The player sprite's pixels
+ */
+void build_collision_masks(collision_masks &masks, const pixel_view &rock, const pixel_view &player)
+{
+    double rock_aspect = static_cast<double>(rock.height) / rock.width;
 
-    // Rocks
-    bitmap rock_bmp = bitmap_named(ROCK_BITMAP);
-    for (int i = 0; i < game.num_rocks; i++)
+    masks.rock.clear();
+    for (int size = static_cast<int>(MIN_ROCK_SIZE); size <= static_cast<int>(MAX_ROCK_SIZE); size++)
     {
-        // Scale the rock bitmap to match the rock's size
-        double scale = game.rocks[i].size / bitmap_width(rock_bmp);
-
-        draw_bitmap(ROCK_BITMAP,
-                    game.rocks[i].position.x - (bitmap_width(rock_bmp) * scale) / 2,
-                    game.rocks[i].position.y - (bitmap_height(rock_bmp) * scale) / 2,
-                    option_scale_bmp(scale, scale));
+        masks.rock.push_back(build_mask(rock, size, static_cast<int>(std::lround(size * rock_aspect))));
     }
+    masks.player = build_mask(player,
+                              static_cast<int>(std::lround(player.width * PLAYER_SCALE)),
+                              static_cast<int>(std::lround(player.height * PLAYER_SCALE)));
 
-    // Draw score and lives text
-    std::string score_text = "Score: " + std::to_string(game.score);
-    std::string lives_text = "Lives: " + std::to_string(game.lives);
+    // The grid assumes rocks reach MAX_ROCK_SIZE / 2 from their centre, tall rock sprites reach further
+    float player_reach = std::hypot(masks.player.width, masks.player.height) / 2;
+    float extra_rock_reach = static_cast<float>(std::max(0.0, MAX_ROCK_SIZE * (rock_aspect - 1) / 2));
+    masks.query_radius = player_reach + extra_rock_reach;
+}
 
-    draw_text(score_text, COLOR_WHITE, 10, 10);
-    draw_text(lives_text, COLOR_WHITE, 10, 40);
+/**
+ * Gets the mask of a rock of a given size
+ *
+ * @param masks The collision masks
+ * @param size  The rock size
+ * @return      The mask for the nearest whole pixel size
+ */
+const collision_mask &rock_mask(const collision_masks &masks, float size)
+{
+    int index = static_cast<int>(std::lround(size - MIN_ROCK_SIZE));
+    return masks.rock[std::min(std::max(index, 0), static_cast<int>(masks.rock.size()) - 1)];
+}
+
+/**
+ * Reads 64 bits of a mask row starting at any bit, which may be before
+ * the start of the row; bits outside the row read as zero
+ *
+ * @param row       The row
+ * @param words     Words in the row
+ * @param first_bit Bit to start at
+ * @return          The bits, first_bit in bit 0
+ */
+uint64_t mask_bits(const uint64_t *row, int words, int first_bit)
+{
+    if (first_bit <= -64 || first_bit >= words * 64)
+        return 0;
+    if (first_bit < 0)
+        return row[0] << -first_bit;
 
-    refresh_screen(60);
+    int word = first_bit / 64;
+    int offset = first_bit % 64;
+    uint64_t bits = row[word] >> offset;
+    if (offset != 0 && word + 1 < words)
+    {
+        bits |= row[word + 1] << (64 - offset);
+    }
+    return bits;
 }
 
 /**
- * Main function - entry point of the program
+ * Tests whether two masks placed on screen share a solid pixel. Their
+ * bounding boxes are checked first; only the overlapping rows and words
+ * are then ANDed together.
  *
- * @return Program exit status (0 = success)
+ * @param a    The first mask
+ * @param a_x  Screen x of the first mask's left edge
+ * @param a_y  Screen y of the first mask's top edge
+ * @param b    The second mask
+ * @param b_x  Screen x of the second mask's left edge
+ * @param b_y  Screen y of the second mask's top edge
+ * @return     True if the masks overlap
  */
-int main()
+bool masks_overlap(const collision_mask &a, int a_x, int a_y, const collision_mask &b, int b_x, int b_y)
 {
-    open_window("Rock Dodge Game", SCREEN_WIDTH, SCREEN_HEIGHT);
+    int left = std::max(a_x, b_x);
+    int right = std::min(a_x + a.width, b_x + b.width);
+    int top = std::max(a_y, b_y);
+    int bottom = std::min(a_y + a.height, b_y + b.height);
+    if (left >= right || top >= bottom)
+        return false;
+
+    // Walk a's words over the overlap, pulling the matching bits out of b
+    int first_word = (left - a_x) / 64;
+    int last_word = (right - 1 - a_x) / 64;
+    int shift = a_x - b_x;
+    for (int y = top; y < bottom; y++)
+    {
+        const uint64_t *a_row = a.bits.data() + static_cast<size_t>(y - a_y) * a.words_per_row;
+        const uint64_t *b_row = b.bits.data() + static_cast<size_t>(y - b_y) * b.words_per_row;
+        for (int word = first_word; word <= last_word; word++)
+        {
+            if (a_row[word] & mask_bits(b_row, b.words_per_row, word * 64 + shift))
+                return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * Tests the player sprite against a batch of candidate rocks pixel by
+ * pixel, using the masks for the sizes they are drawn at
+ *
+ * @param rocks      The rock pool
+ * @param candidates Indices of the rocks to test
+ * @param masks      The collision masks
+ * @param x          Player x
+ * @param y          Player y, the sprite is drawn PLAYER_VERTICAL_OFFSET above it
+ * @param hits       Receives the indices of the rocks overlapping the player
+ */
+void collide_masks(const rock_pool &rocks, const std::vector<int> &candidates, const collision_masks &masks,
+                   float x, float y, std::vector<int> &hits)
+{
+    const collision_mask &player = masks.player;
+    int player_x = static_cast<int>(std::lround(x - player.width / 2.0));
+    int player_y = static_cast<int>(std::lround(y - PLAYER_VERTICAL_OFFSET - player.height / 2.0));
 
-    music boss_music = load_music("boss_music", "boss_battle.mp3");
-    play_music(boss_music, 0.7, true);
+    hits.clear();
+    for (int index : candidates)
+    {
+        const collision_mask &rock = rock_mask(masks, rocks.size[index]);
+        int rock_x = static_cast<int>(std::lround(rocks.x[index] - rock.width / 2.0));
+        int rock_y = static_cast<int>(std::lround(rocks.y[index] - rock.height / 2.0));
+        if (masks_overlap(player, player_x, player_y, rock, rock_x, rock_y))
+        {
+            hits.push_back(index);
+        }
+    }
+}
 
-    load_bitmap("rock_image", "fire_img.png");
-    load_bitmap("player_image", "main_char.png");
-    game_data game;
-    init_game(game);
+/**
+ * Converts a time in milliseconds to simulation ticks
+ *
+ * @param ms The time in milliseconds
+ * @return   The number of ticks
+ */
+long long ms_to_ticks(unsigned int ms)
+{
+    return static_cast<long long>(ms) * SIMULATION_RATE / 1000;
+}
 
-    const int FPS = 60;
-    const int frame_delay = 1000 / FPS;
+/**
+ * Initializes the game data to start a new game
+ *
+ * @param game The game data to initialize
+ * @param seed Seed for the game's random generator, the same seed and inputs replay the same game
+ */
+void init_game(game_data &game, unsigned int seed)
+{
+    game.player_position = point_at(SCREEN_WIDTH / 2.0f, SCREEN_HEIGHT - PLAYER_SIZE * 2);
+    game.previous_player_position = game.player_position;
+    game.rng.state = seed;
+    game.tick = 0;
+    game.next_rock_tick = ms_to_ticks(1000);
+    game.score = 0;
+    game.lives = INITIAL_LIVES;
+    game.rocks = rock_pool(); // Start with no rocks
+    init_grid(game.grid);
+    game.masks = nullptr;
+    game.zones = nullptr;
+}
 
-    unsigned int frame_start;
-    int frame_time;
+/**
+ * Kernel pass 1: moves every rock down by its speed
+ *
+ * @param rocks The rocks to move
+ */
+void integrate_rocks(rock_pool &rocks)
+{
+    float *y = rocks.y.data();
+    const float *speed = rocks.speed.data();
+    int num_rocks = rock_count(rocks);
+    int i = 0;
 
-    while (!game.quit && game.lives > 0)
+#if defined(__AVX2__)
+    for (; i + 8 <= num_rocks; i += 8)
     {
-        frame_start = current_ticks();
+        _mm256_storeu_ps(y + i, _mm256_add_ps(_mm256_loadu_ps(y + i), _mm256_loadu_ps(speed + i)));
+    }
+#endif
 
-        update_game(game);
+    for (; i < num_rocks; i++)
+    {
+        y[i] += speed[i];
+    }
+}
 
-        handle_input(game);
+/**
+ * Kernel pass 2: flags the rocks that fell past the bottom of the screen,
+ * overwriting the flags of every rock
+ *
+ * @param rocks The rocks to test
+ * @param flags Receives ROCK_OFF_SCREEN or 0 for each rock
+ */
+void flag_off_screen_rocks(const rock_pool &rocks, std::vector<uint8_t> &flags)
+{
+    const float *y = rocks.y.data();
+    const float *size = rocks.size.data();
+    int num_rocks = rock_count(rocks);
+    int i = 0;
 
-        draw_game(game);
+    flags.resize(num_rocks);
+    uint8_t *out = flags.data();
 
-        frame_time = current_ticks() - frame_start;
-        if (frame_delay > frame_time)
+#if defined(__AVX2__)
+    const __m256 bottom = _mm256_set1_ps(static_cast<float>(SCREEN_HEIGHT));
+    for (; i + 8 <= num_rocks; i += 8)
+    {
+        __m256 top = _mm256_sub_ps(_mm256_loadu_ps(y + i), _mm256_loadu_ps(size + i));
+        int mask = _mm256_movemask_ps(_mm256_cmp_ps(top, bottom, _CMP_GT_OQ));
+        for (int lane = 0; lane < 8; lane++)
         {
-            delay(frame_delay - frame_time);
+            out[i + lane] = (mask >> lane) & ROCK_OFF_SCREEN;
         }
     }
+#endif
 
-    if (game.lives <= 0)
+    for (; i < num_rocks; i++)
     {
-        clear_screen(COLOR_BLACK);
+        out[i] = y[i] - size[i] > SCREEN_HEIGHT ? ROCK_OFF_SCREEN : 0;
+    }
+}
 
-        std::string game_over_text = "Game Over! Final Score: " + std::to_string(game.score);
-        draw_text(game_over_text,
-                  COLOR_WHITE,
-                  SCREEN_WIDTH / 2 - 100,
-                  SCREEN_HEIGHT / 2);
-        refresh_screen(60);
+/**
+ * Kernel pass 3: flags the rocks that hit the player, using the grid
+ * broadphase and the squared distance narrowphase. Only a handful of rocks
+ * survive the broadphase, so this pass stays scalar.
+ *
+ * @param game The game data, its rock flags are updated
+ */
+void flag_player_hits(game_data &game)
+{
+    float player_x = static_cast<float>(game.player_position.x);
+    float player_y = static_cast<float>(game.player_position.y);
 
-        delay(3000);
+    build_grid(game.grid, game.rocks, game.rock_flags);
+    if (game.masks)
+    {
+        float sprite_y = player_y - static_cast<float>(PLAYER_VERTICAL_OFFSET);
+        query_grid(game.grid, player_x, sprite_y, game.masks->query_radius, game.candidates);
+        collide_masks(game.rocks, game.candidates, *game.masks, player_x, player_y, game.hits);
+    }
+    else
+    {
+        query_grid(game.grid, player_x, player_y, PLAYER_SIZE / 2.0f, game.candidates);
+        collide_circle(game.rocks, game.candidates, player_x, player_y, PLAYER_SIZE / 2.0f, game.hits);
     }
 
-    stop_music();
-    free_music(boss_music);
+    for (int index : game.hits)
+    {
+        game.rock_flags[index] |= ROCK_HIT_PLAYER;
+    }
+}
+
+/**
+ * Kernel pass 4: removes every flagged rock in a single order preserving
+ * pass, adding the size of rocks that left the screen to the score and
+ * taking a life for each rock that hit the player
+ *
+ * @param game The game data to compact
+ */
+void compact_rocks(game_data &game)
+{
+    rock_pool &rocks = game.rocks;
+    const uint8_t *flags = game.rock_flags.data();
+    int num_rocks = rock_count(rocks);
+    int kept = 0;
+
+    for (int i = 0; i < num_rocks; i++)
+    {
+        if (flags[i] == 0)
+        {
+            if (kept != i)
+            {
+                rocks.x[kept] = rocks.x[i];
+                rocks.y[kept] = rocks.y[i];
+                rocks.size[kept] = rocks.size[i];
+                rocks.speed[kept] = rocks.speed[i];
+            }
+            kept++;
+        }
+        else if (flags[i] & ROCK_OFF_SCREEN)
+        {
+            game.score += static_cast<int>(rocks.size[i]); // Add rock size to score
+        }
+        else
+        {
+            game.lives--; // Lose a life
+        }
+    }
+
+    rocks.x.resize(kept);
+    rocks.y.resize(kept);
+    rocks.size.resize(kept);
+    rocks.speed.resize(kept);
+}
+
+/**
+ * Moves every rock for one frame, scoring and removing rocks that left the
+ * screen and costing a life for rocks that hit the player. Runs the rock
+ * kernel passes in order: integrate, flag, collide, compact.
+ *
+ * @param game The game data to update
+ */
+void update_rocks(game_data &game)
+{
+    integrate_rocks(game.rocks);
+    flag_off_screen_rocks(game.rocks, game.rock_flags);
+    {
+        profile_scope collision(game.zones, PROFILE_COLLISION);
+        flag_player_hits(game);
+    }
+    compact_rocks(game);
+}
+
+/**
+ * Moves the player for one tick
+ *
+ * @param game  The game data to update
+ * @param input The player's input
+ */
+void move_player(game_data &game, const player_input &input)
+{
+    game.previous_player_position = game.player_position;
+
+    if (input.left)
+    {
+        game.player_position.x -= PLAYER_SPEED;
+        if (game.player_position.x < PLAYER_SIZE / 2.0f)
+        {
+            game.player_position.x = PLAYER_SIZE / 2.0f;
+        }
+    }
+    if (input.right)
+    {
+        game.player_position.x += PLAYER_SPEED;
+        if (game.player_position.x > SCREEN_WIDTH - PLAYER_SIZE / 2.0f)
+        {
+            game.player_position.x = SCREEN_WIDTH - PLAYER_SIZE / 2.0f;
+        }
+    }
+}
+
+/**
+ * Updates the game state for one fixed simulation tick
+ *
+ * @param game  The game data to update
+ * @param input The player's input for this tick
+ */
+void update_game(game_data &game, const player_input &input)
+{
+    profile_scope update(game.zones, PROFILE_UPDATE);
+
+    move_player(game, input);
+
+    // Spawn timing runs on simulated time, never the wall clock
+    if (game.tick >= game.next_rock_tick)
+    {
+        add_rock(game);
+
+        int delay_ms = random_int(game.rng, 1000, 2000); // <-- made the game a bit harder
+        game.next_rock_tick = game.tick + ms_to_ticks(delay_ms);
+    }
+    game.tick++;
+
+    // Update all rocks
+    update_rocks(game);
+}
+
+/**
+ * Handles user input for one frame. Must be called on the main thread.
+ *
+ * @param input Receives the movement keys held this frame
+ * @return      True if the window was closed
+ */
+bool handle_input(player_input &input)
+{
+    process_events();
+
+    // Handle keyboard input for player movement
+    input.left = key_down(LEFT_KEY) || key_down(A_KEY);
+    input.right = key_down(RIGHT_KEY) || key_down(D_KEY);
+
+    return quit_requested();
+}
+
+/**
+ * Copies what draw_game needs out of the game. The vectors keep their
+ * capacity, so once warmed up this does not allocate.
+ *
+ * @param game     The game to copy from
+ * @param snapshot The snapshot to fill
+ */
+void take_snapshot(const game_data &game, render_snapshot &snapshot)
+{
+    snapshot.rocks.x = game.rocks.x;
+    snapshot.rocks.y = game.rocks.y;
+    snapshot.rocks.size = game.rocks.size;
+    snapshot.rocks.speed = game.rocks.speed;
+    snapshot.player_position = game.player_position;
+    snapshot.previous_player_position = game.previous_player_position;
+    snapshot.score = game.score;
+    snapshot.lives = game.lives;
+    snapshot.tick = game.tick;
+}
+
+/**
+ * Runs the ticks for one frame and snapshots the result
+ *
+ * @param game     The game to advance
+ * @param job      The frame to simulate
+ * @param snapshot Receives the state to draw
+ */
+void simulate_frame(game_data &game, const simulation_job &job, render_snapshot &snapshot)
+{
+    snapshot.zones = zone_times();
+    game.zones = job.profile ? &snapshot.zones : nullptr;
+    for (int i = 0; i < job.ticks && game.lives > 0; i++)
+    {
+        update_game(game, job.input);
+    }
+    game.zones = nullptr;
+
+    take_snapshot(game, snapshot);
+    snapshot.alpha = job.alpha;
+    snapshot.input_time = job.input_time;
+}
+
+/**
+ * Body of the simulation thread: simulates each posted frame until told
+ * to stop
+ *
+ * @param pipeline The hand off with the main thread
+ * @param game     The game, owned by this thread until it exits
+ */
+void run_simulation(frame_pipeline &pipeline, game_data &game)
+{
+    std::unique_lock<std::mutex> guard(pipeline.lock);
+    while (true)
+    {
+        pipeline.changed.wait(guard, [&pipeline]
+                              { return pipeline.job_ready || pipeline.stop; });
+        if (pipeline.stop)
+            return;
+
+        simulation_job job = pipeline.job;
+        pipeline.job_ready = false;
+
+        // back is only read by the main thread after job_done is set
+        guard.unlock();
+        simulate_frame(game, job, pipeline.back);
+        guard.lock();
+
+        pipeline.job_done = true;
+        pipeline.changed.notify_all();
+    }
+}
+
+/**
+ * Posts the next frame to the simulation thread
+ *
+ * @param pipeline The hand off with the simulation thread
+ * @param job      The frame to simulate
+ */
+void submit_frame(frame_pipeline &pipeline, const simulation_job &job)
+{
+    std::lock_guard<std::mutex> guard(pipeline.lock);
+    pipeline.job = job;
+    pipeline.job_ready = true;
+    pipeline.job_done = false;
+    pipeline.changed.notify_all();
+}
+
+/**
+ * Waits for the simulation thread to finish the posted frame, then swaps
+ * its snapshot with the one just drawn
+ *
+ * @param pipeline The hand off with the simulation thread
+ * @param front    The snapshot the main thread draws from
+ */
+void wait_for_frame(frame_pipeline &pipeline, render_snapshot &front)
+{
+    std::unique_lock<std::mutex> guard(pipeline.lock);
+    pipeline.changed.wait(guard, [&pipeline]
+                          { return pipeline.job_done; });
+    std::swap(front, pipeline.back);
+    pipeline.job_done = false;
+}
+
+/**
+ * Tells the simulation thread to exit and waits for it
+ *
+ * @param pipeline   The hand off with the simulation thread
+ * @param simulation The simulation thread
+ */
+void stop_simulation(frame_pipeline &pipeline, std::thread &simulation)
+{
+    {
+        std::lock_guard<std::mutex> guard(pipeline.lock);
+        pipeline.stop = true;
+        pipeline.changed.notify_all();
+    }
+    simulation.join();
+}
+
+/**
+ * A simple AI player for headless runs: dodges the lowest rock that is
+ * about to land on the player, otherwise drifts back to the middle
+ *
+ * @param game The game data to look at
+ * @return     The input for the next tick
+ */
+player_input autopilot_input(const game_data &game)
+{
+    const float LOOKAHEAD = 250.0f; // How far above the player rocks are considered
+    const float MARGIN = 10.0f;     // Extra clearance the AI keeps from rocks
+
+    const rock_pool &rocks = game.rocks;
+    float player_x = static_cast<float>(game.player_position.x);
+    float player_y = static_cast<float>(game.player_position.y);
+    if (game.masks)
+    {
+        player_y -= static_cast<float>(PLAYER_VERTICAL_OFFSET); // Rocks collide with the sprite, not the position
+    }
+
+    int threat = -1;
+    for (int i = 0; i < rock_count(rocks); i++)
+    {
+        float gap = player_y - rocks.y[i];
+        float reach = rocks.size[i] / 2 + PLAYER_SIZE / 2.0f + MARGIN;
+        if (gap > -reach && gap < LOOKAHEAD && std::fabs(rocks.x[i] - player_x) < reach &&
+            (threat < 0 || rocks.y[i] > rocks.y[threat]))
+        {
+            threat = i;
+        }
+    }
+
+    player_input input = {false, false};
+    if (threat >= 0)
+    {
+        // Move away from the rock, unless that would pin the player against a wall
+        float reach = rocks.size[threat] / 2 + PLAYER_SIZE + MARGIN;
+        bool go_left = rocks.x[threat] > player_x;
+        if (go_left && player_x < reach)
+            go_left = false;
+        else if (!go_left && player_x > SCREEN_WIDTH - reach)
+            go_left = true;
+
+        input.left = go_left;
+        input.right = !go_left;
+    }
+    else if (player_x < SCREEN_WIDTH / 2.0f - PLAYER_SPEED)
+    {
+        input.right = true;
+    }
+    else if (player_x > SCREEN_WIDTH / 2.0f + PLAYER_SPEED)
+    {
+        input.left = true;
+    }
+    return input;
+}
+
+/**
+ * Records how long a frame took
+ *
+ * @param stats      The session's frame stats
+ * @param frame_time Time from the start of this frame to the start of the next
+ */
+void record_frame(frame_stats &stats, std::chrono::nanoseconds frame_time)
+{
+    stats.frame_ms.push_back(std::chrono::duration<float, std::milli>(frame_time).count());
+    if (frame_time > FRAME_DURATION * 3 / 2)
+    {
+        stats.dropped_frames++;
+    }
+}
+
+/**
+ * Prints frame time percentiles and dropped frames for the session
+ *
+ * @param stats The session's frame stats
+ */
+void report_frame_stats(const frame_stats &stats)
+{
+    if (stats.frame_ms.empty())
+        return;
+
+    std::vector<float> sorted = stats.frame_ms;
+    std::sort(sorted.begin(), sorted.end());
+    auto percentile = [&sorted](double p)
+    {
+        return std::to_string(sorted[static_cast<size_t>(p * (sorted.size() - 1))]);
+    };
+
+    double total_ms = 0;
+    for (float frame_ms : sorted)
+    {
+        total_ms += frame_ms;
+    }
+
+    write_line("Frames: " + std::to_string(sorted.size()) + ", ticks: " + std::to_string(stats.ticks) +
+               ", " + std::to_string(sorted.size() * 1000.0 / total_ms) + " frames/s");
+    write_line("Frame time (ms): p50 " + percentile(0.5) + ", p90 " + percentile(0.9) +
+               ", p99 " + percentile(0.99) + ", max " + percentile(1.0));
+    write_line("Dropped frames: " + std::to_string(stats.dropped_frames));
+
+    sorted = stats.latency_ms;
+    std::sort(sorted.begin(), sorted.end());
+    write_line("Input latency (ms): p50 " + percentile(0.5) + ", p90 " + percentile(0.9) +
+               ", p99 " + percentile(0.99) + ", max " + percentile(1.0));
+}
+
+/**
+ * Reads a whole file, so it is in the OS cache before the main thread
+ * decodes it. Runs on a background thread.
+ *
+ * @param path The file to read
+ * @return     True if the file could be read
+ */
+bool prefetch_file(const std::string &path)
+{
+    std::ifstream file(path, std::ios::binary);
+    std::vector<char> buffer(1 << 16);
+    while (file.read(buffer.data(), buffer.size()) || file.gcount() > 0)
+    {
+    }
+    return file.eof();
+}
+
+/**
+ * Starts loading the game assets of one kind, reading the files on
+ * background threads
+ *
+ * @param kind Whether to load the bitmaps or the music
+ * @return     The assets being loaded
+ */
+std::vector<pending_asset> start_asset_loading(asset_kind kind)
+{
+    std::vector<pending_asset> pending;
+    if (kind == BITMAP_ASSET)
+    {
+        pending.push_back({BITMAP_ASSET, ROCK_BITMAP, "fire_img.png", {}, false});
+        pending.push_back({BITMAP_ASSET, PLAYER_BITMAP, "main_char.png", {}, false});
+    }
+    else
+    {
+        pending.push_back({MUSIC_ASSET, BACKGROUND_MUSIC, "boss_battle.mp3", {}, false});
+    }
+
+    for (pending_asset &asset : pending)
+    {
+        asset.file_read = std::async(std::launch::async, prefetch_file, asset.path);
+    }
+    return pending;
+}
+
+/**
+ * Creates the next asset once its file has been read, waiting for the file
+ * no later than the deadline. Only the file read happens in the background:
+ * SplashKit decodes from a file on the calling thread, so each call can
+ * take as long as one decode.
+ *
+ * @param pending  The assets being loaded
+ * @param deadline How long the caller can afford to wait
+ */
+void poll_assets(std::vector<pending_asset> &pending, std::chrono::steady_clock::time_point deadline)
+{
+    for (pending_asset &asset : pending)
+    {
+        if (asset.loaded)
+            continue;
+
+        if (asset.file_read.wait_until(deadline) != std::future_status::ready)
+            return;
+
+        if (!asset.file_read.get())
+        {
+            write_line("Could not read " + asset.path);
+        }
+
+        if (asset.kind == BITMAP_ASSET)
+            load_bitmap(asset.name, asset.path);
+        else
+            load_music(asset.name, asset.path);
+        asset.loaded = true;
+        return;
+    }
+}
+
+/**
+ * Counts the assets that are not loaded yet
+ *
+ * @param pending The assets being loaded
+ * @return        How many are still loading
+ */
+int assets_remaining(const std::vector<pending_asset> &pending)
+{
+    int remaining = 0;
+    for (const pending_asset &asset : pending)
+    {
+        if (!asset.loaded)
+            remaining++;
+    }
+    return remaining;
+}
+
+/**
+ * Draws the loading screen with a progress bar
+ *
+ * @param progress How much has loaded, 0 to 1
+ */
+void draw_loading_screen(double progress)
+{
+    const double BAR_WIDTH = 300;
+    const double BAR_HEIGHT = 20;
+    double bar_x = (SCREEN_WIDTH - BAR_WIDTH) / 2;
+    double bar_y = SCREEN_HEIGHT / 2.0;
+
+    clear_screen(COLOR_BLACK);
+    draw_text("Loading...", COLOR_WHITE, bar_x, bar_y - 20);
+    draw_rectangle(COLOR_WHITE, bar_x, bar_y, BAR_WIDTH, BAR_HEIGHT);
+    fill_rectangle(COLOR_WHITE, bar_x, bar_y, BAR_WIDTH * progress, BAR_HEIGHT);
+}
+
+/**
+ * Caches the handles and sizes of the loaded game bitmaps
+ *
+ * @param assets The assets to fill in
+ */
+void cache_assets(game_assets &assets)
+{
+    assets.rock = bitmap_named(ROCK_BITMAP);
+    assets.player = bitmap_named(PLAYER_BITMAP);
+    assets.rock_width = bitmap_width(assets.rock);
+    assets.rock_height = bitmap_height(assets.rock);
+    assets.player_width = bitmap_width(assets.player);
+    assets.player_height = bitmap_height(assets.player);
+}
+
+/**
+ * Loads the game bitmaps synchronously and caches their handles and sizes
+ *
+ * @param assets The assets to fill in
+ */
+void load_assets(game_assets &assets)
+{
+    load_bitmap(ROCK_BITMAP, "fire_img.png");
+    load_bitmap(PLAYER_BITMAP, "main_char.png");
+    cache_assets(assets);
+}
+
+/**
+ * Builds the collision masks from the sprites' decoded pixels in the asset
+ * pack. Without a pack, the pixels are read back from the sprite bitmaps
+ * once they are loaded and saved as the pack, so only the first launch
+ * pays for the readback.
+ *
+ * @param masks The masks to fill in
+ * @param pack  The asset pack, may be closed
+ * @return      True if the masks were built, false when there is no pack and
+ *              the bitmaps aren't loaded (headless games)
+ */
+bool load_collision_masks(collision_masks &masks, const asset_pack &pack)
+{
+    pixel_view rock;
+    pixel_view player;
+    if (pack_pixels(pack, ROCK_BITMAP, rock) && pack_pixels(pack, PLAYER_BITMAP, player))
+    {
+        build_collision_masks(masks, rock, player);
+        return true;
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    asset_pack_builder builder;
+    if (!add_pack_bitmap(builder, ROCK_BITMAP) || !add_pack_bitmap(builder, PLAYER_BITMAP) ||
+        !built_pixels(builder, ROCK_BITMAP, rock) || !built_pixels(builder, PLAYER_BITMAP, player))
+        return false;
+
+    build_collision_masks(masks, rock, player);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    write_line("Read sprite pixels back for the collision masks in " + std::to_string(ms) + " ms");
+    write_line(write_asset_pack(builder, ASSET_PACK_FILE) ? "Saved asset pack " + ASSET_PACK_FILE
+                                                           : "Could not save asset pack " + ASSET_PACK_FILE);
+    return true;
+}
+
+/**
+ * Empties a sprite list ready for a new frame, keeping its capacity
+ *
+ * @param sprites The list to reset
+ * @param bmp     The bitmap the sprites use
+ */
+void begin_sprites(sprite_list &sprites, bitmap bmp)
+{
+    sprites.bmp = bmp;
+    sprites.x.clear();
+    sprites.y.clear();
+    sprites.scale.clear();
+}
+
+/**
+ * Draws every sprite in a list
+ *
+ * @param sprites The sprites to draw
+ */
+void draw_sprites(const sprite_list &sprites)
+{
+    for (size_t i = 0; i < sprites.x.size(); i++)
+    {
+        draw_bitmap(sprites.bmp, sprites.x[i], sprites.y[i], option_scale_bmp(sprites.scale[i], sprites.scale[i]));
+    }
+}
+
+/**
+ * Places every rock in a sprite list. The rock bitmap is scaled so its
+ * width matches the rock's size, which makes the placement pure arithmetic
+ * on the rock arrays.
+ *
+ * @param sprites The list to fill, already begun with the rock bitmap
+ * @param rocks   The rocks to draw
+ * @param assets  The cached bitmap sizes
+ * @param alpha   How far between the previous and the current tick to draw, 0 to 1
+ */
+void place_rocks(sprite_list &sprites, const rock_pool &rocks, const game_assets &assets, float alpha)
+{
+    int num_rocks = rock_count(rocks);
+    float inverse_width = static_cast<float>(1.0 / assets.rock_width);
+    float half_aspect = static_cast<float>(assets.rock_height / assets.rock_width / 2);
+
+    sprites.x.resize(num_rocks);
+    sprites.y.resize(num_rocks);
+    sprites.scale.resize(num_rocks);
+
+    for (int i = 0; i < num_rocks; i++)
+    {
+        sprites.scale[i] = rocks.size[i] * inverse_width;
+        sprites.x[i] = rocks.x[i] - rocks.size[i] / 2;
+        // Rocks move in a straight line, so the previous tick's position is y - speed
+        sprites.y[i] = rocks.y[i] - rocks.speed[i] * (1 - alpha) - rocks.size[i] * half_aspect;
+    }
+}
+
+/**
+ * Draws a snapshot of the game to the screen, part way between its last
+ * two ticks
+ *
+ * @param snapshot The game state to draw
+ * @param assets   The cached bitmaps to draw with
+ * @param rocks    Reusable list for the rock sprites
+ */
+void draw_game(const render_snapshot &snapshot, const game_assets &assets, sprite_list &rocks)
+{
+    float alpha = snapshot.alpha;
+
+    clear_screen(COLOR_BLACK);
+
+    // Player bitmap, interpolated between the last two ticks
+    double player_x = snapshot.previous_player_position.x + (snapshot.player_position.x - snapshot.previous_player_position.x) * alpha;
+    double player_y = snapshot.previous_player_position.y + (snapshot.player_position.y - snapshot.previous_player_position.y) * alpha;
+    draw_bitmap(assets.player,
+                player_x - (assets.player_width * PLAYER_SCALE) / 2,
+                player_y - (assets.player_height * PLAYER_SCALE) / 2 - PLAYER_VERTICAL_OFFSET,
+                option_scale_bmp(PLAYER_SCALE, PLAYER_SCALE));
+
+    // Rocks, all sharing one bitmap
+    begin_sprites(rocks, assets.rock);
+    place_rocks(rocks, snapshot.rocks, assets, alpha);
+    draw_sprites(rocks);
+
+    // Draw score and lives text
+    std::string score_text = "Score: " + std::to_string(snapshot.score);
+    std::string lives_text = "Lives: " + std::to_string(snapshot.lives);
+
+    draw_text(score_text, COLOR_WHITE, 10, 10);
+    draw_text(lives_text, COLOR_WHITE, 10, 40);
+}
+
+/**
+ * Benchmarks the rock kernel on a large pool, timing each pass separately
+ * and topping the pool back up after every frame so the rock count stays
+ * constant. Nothing is drawn and no window is opened.
+ *
+ * @param num_rocks How many rocks to simulate
+ * @param frames    How many frames to time
+ */
+void benchmark_rock_update(int num_rocks, int frames)
+{
+    game_data game;
+    init_game(game, 12345);
+
+    const char *pass_names[] = {"integrate", "off-screen mask", "collision mask", "compact"};
+    double pass_ns[4] = {0, 0, 0, 0};
+    long long rocks_updated = 0;
+
+    for (int frame = 0; frame < frames; frame++)
+    {
+        // Refill outside the timed region, spreading new rocks over the screen
+        while (rock_count(game.rocks) < num_rocks)
+        {
+            push_rock(game.rocks, create_rock(game.rng));
+            game.rocks.y.back() = random_float(game.rng, 0.0f, static_cast<float>(SCREEN_HEIGHT));
+        }
+
+        auto t0 = std::chrono::steady_clock::now();
+        integrate_rocks(game.rocks);
+        auto t1 = std::chrono::steady_clock::now();
+        flag_off_screen_rocks(game.rocks, game.rock_flags);
+        auto t2 = std::chrono::steady_clock::now();
+        flag_player_hits(game);
+        auto t3 = std::chrono::steady_clock::now();
+        compact_rocks(game);
+        auto t4 = std::chrono::steady_clock::now();
+
+        pass_ns[0] += std::chrono::duration<double, std::nano>(t1 - t0).count();
+        pass_ns[1] += std::chrono::duration<double, std::nano>(t2 - t1).count();
+        pass_ns[2] += std::chrono::duration<double, std::nano>(t3 - t2).count();
+        pass_ns[3] += std::chrono::duration<double, std::nano>(t4 - t3).count();
+        rocks_updated += num_rocks;
+    }
+
+#if defined(__AVX2__)
+    write_line("Rock kernel: AVX2");
+#else
+    write_line("Rock kernel: scalar");
+#endif
+    write_line("Rocks: " + std::to_string(num_rocks) + ", frames: " + std::to_string(frames));
+
+    double total_ns = 0;
+    for (int pass = 0; pass < 4; pass++)
+    {
+        total_ns += pass_ns[pass];
+        write_line("  " + std::string(pass_names[pass]) + ": " + std::to_string(pass_ns[pass] / rocks_updated) + " ns/rock");
+    }
+    write_line("Update time per frame: " + std::to_string(total_ns / frames / 1e6) + " ms");
+    write_line("Update cost per rock: " + std::to_string(total_ns / rocks_updated) + " ns");
+}
+
+/**
+ * Benchmarks drawing a frame with many rocks on screen. The frame rate is
+ * not capped, so the time measured is the cost of draw_game plus
+ * presenting the frame.
+ *
+ * @param num_rocks How many rocks to draw
+ * @param frames    How many frames to time
+ */
+void benchmark_draw(int num_rocks, int frames)
+{
+    open_window("Rock Dodge Draw Benchmark", SCREEN_WIDTH, SCREEN_HEIGHT);
+
+    game_assets assets;
+    load_assets(assets);
+    sprite_list rock_sprites;
+
+    game_data game;
+    init_game(game, 12345);
+
+    for (int i = 0; i < num_rocks; i++)
+    {
+        push_rock(game.rocks, create_rock(game.rng));
+        game.rocks.y.back() = random_float(game.rng, 0.0f, static_cast<float>(SCREEN_HEIGHT));
+    }
+
+    render_snapshot snapshot;
+    take_snapshot(game, snapshot);
+    snapshot.alpha = 1.0f;
+
+    double total_ms = 0;
+    double worst_ms = 0;
+    for (int frame = 0; frame < frames; frame++)
+    {
+        process_events();
+
+        auto start = std::chrono::steady_clock::now();
+        draw_game(snapshot, assets, rock_sprites);
+        refresh_screen();
+        double frame_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        total_ms += frame_ms;
+        worst_ms = std::max(worst_ms, frame_ms);
+    }
+
+    close_window("Rock Dodge Draw Benchmark");
+
+    write_line("Rocks on screen: " + std::to_string(num_rocks) + ", frames: " + std::to_string(frames));
+    write_line("Frame time: average " + std::to_string(total_ms / frames) + " ms, worst " + std::to_string(worst_ms) + " ms");
+}
+
+/**
+ * Plays games with no window, audio or assets, driven by the autopilot on
+ * simulated time. Game n is seeded with seed + n, so any game can be
+ * reproduced exactly (with the same collision masks).
+ *
+ * @param games     How many games to play
+ * @param seed      Seed of the first game
+ * @param max_ticks Ticks after which a game is stopped if the AI is still alive
+ * @param masks     Sprite collision masks, or nullptr to collide circles
+ */
+void run_headless(int games, unsigned int seed, long long max_ticks, const collision_masks *masks)
+{
+    long long total_ticks = 0;
+    long long total_score = 0;
+    int min_score = 0;
+    int max_score = 0;
+    int survived = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (int n = 0; n < games; n++)
+    {
+        game_data game;
+        init_game(game, seed + n);
+        game.masks = masks;
+
+        while (game.lives > 0 && game.tick < max_ticks)
+        {
+            update_game(game, autopilot_input(game));
+        }
+
+        total_ticks += game.tick;
+        total_score += game.score;
+        min_score = n == 0 ? game.score : std::min(min_score, game.score);
+        max_score = n == 0 ? game.score : std::max(max_score, game.score);
+        if (game.lives > 0)
+        {
+            survived++;
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    write_line("Seed: " + std::to_string(seed) + ", games: " + std::to_string(games) +
+               ", tick limit: " + std::to_string(max_ticks));
+    write_line("Score: average " + std::to_string(static_cast<double>(total_score) / std::max(games, 1)) +
+               ", min " + std::to_string(min_score) + ", max " + std::to_string(max_score));
+    write_line("Survived to the tick limit: " + std::to_string(survived));
+    if (seconds > 0)
+    {
+        write_line("Speed: " + std::to_string(games / seconds) + " games/s, " +
+                   std::to_string(total_ticks / seconds) + " ticks/s");
+    }
+}
+
+/**
+ * Prints how long after start up a milestone was reached
+ *
+ * @param milestone    What was reached
+ * @param program_start When the program started
+ */
+void report_startup_time(const std::string &milestone, std::chrono::steady_clock::time_point program_start)
+{
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - program_start).count();
+    write_line(milestone + ": " + std::to_string(ms) + " ms");
+}
+
+/**
+ * Main function - entry point of the program
+ *
+ * Usage: rock-dodge-game                      play the game
+ *        rock-dodge-game --bench-rocks <n>    benchmark the rock kernel with n rocks (e.g. 1000000)
+ *        rock-dodge-game --bench-draw <n>     benchmark drawing with n rocks on screen (e.g. 10000)
+ *        rock-dodge-game --headless <games> [--seed <s>] [--max-ticks <t>]
+ *                                             play games with the AI and no window
+ *        rock-dodge-game --seed <s>           play a reproducible game
+ *
+ * @return Program exit status (0 = success)
+ */
+int main(int argc, char *argv[])
+{
+    std::chrono::steady_clock::time_point program_start = std::chrono::steady_clock::now();
+    unsigned int seed = std::random_device()();
+    int headless_games = 0;
+    long long max_ticks = DEFAULT_HEADLESS_TICKS;
+    bool single_threaded = false;
+    bool uncapped = false;
+    std::string profile_csv;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string option = argv[i];
+        if (option == "--single-threaded")
+        {
+            single_threaded = true;
+            continue;
+        }
+        if (option == "--uncapped")
+        {
+            uncapped = true;
+            continue;
+        }
+        if (i + 1 >= argc)
+            break;
+
+        if (option == "--bench-rocks")
+        {
+            benchmark_rock_update(std::stoi(argv[i + 1]), 600);
+            return 0;
+        }
+        if (option == "--bench-draw")
+        {
+            benchmark_draw(std::stoi(argv[i + 1]), 300);
+            return 0;
+        }
+        if (option == "--seed")
+        {
+            seed = static_cast<unsigned int>(std::stoul(argv[++i]));
+        }
+        else if (option == "--headless")
+        {
+            headless_games = std::stoi(argv[++i]);
+        }
+        else if (option == "--max-ticks")
+        {
+            max_ticks = std::stoll(argv[++i]);
+        }
+        else if (option == "--profile-csv")
+        {
+            profile_csv = argv[++i];
+        }
+    }
+
+    if (headless_games > 0)
+    {
+        // Headless games use the sprite masks when the asset pack is there, no bitmaps are loaded
+        asset_pack pack;
+        collision_masks masks;
+        bool have_masks = open_asset_pack(pack, ASSET_PACK_FILE) && load_collision_masks(masks, pack);
+        write_line(have_masks ? "Collision: sprite masks" : "Collision: circles (no asset pack)");
+        run_headless(headless_games, seed, max_ticks, have_masks ? &masks : nullptr);
+        close_asset_pack(pack);
+        return 0;
+    }
+
+    open_window("Rock Dodge Game", SCREEN_WIDTH, SCREEN_HEIGHT);
+
+    // Show a loading screen while the sprites load. Gameplay only needs those, so the
+    // music file is read in the background meanwhile and decoded once play has started.
+    asset_pack pack;
+    if (open_asset_pack(pack, ASSET_PACK_FILE))
+    {
+        write_line("Using asset pack " + ASSET_PACK_FILE);
+    }
+    std::vector<pending_asset> pending = start_asset_loading(BITMAP_ASSET);
+    std::vector<pending_asset> music = start_asset_loading(MUSIC_ASSET);
+    int total_assets = assets_remaining(pending);
+    bool first_loading_frame = true;
+
+    while (assets_remaining(pending) > 0)
+    {
+        std::chrono::steady_clock::time_point frame_start = std::chrono::steady_clock::now();
+        process_events();
+        if (quit_requested())
+        {
+            close_asset_pack(pack);
+            close_window("Rock Dodge Game");
+            return 0;
+        }
+
+        draw_loading_screen(1.0 - static_cast<double>(assets_remaining(pending)) / total_assets);
+        refresh_screen();
+        if (first_loading_frame)
+        {
+            report_startup_time("Time to first frame", program_start);
+            first_loading_frame = false;
+        }
+
+        poll_assets(pending, frame_start + FRAME_DURATION);
+    }
+
+    game_assets assets;
+    cache_assets(assets);
+    sprite_list rock_sprites;
+
+    write_line("Seed: " + std::to_string(seed));
+    game_data game;
+    init_game(game, seed);
+
+    collision_masks masks;
+    if (load_collision_masks(masks, pack))
+    {
+        game.masks = &masks;
+    }
+    write_line(game.masks ? "Collision: sprite masks" : "Collision: circles (sprites could not be read)");
+
+    // Fixed timestep: the simulation advances in TICK_DURATION steps however long frames take,
+    // and this loop is the only thing pacing frames (refresh_screen is not given a frame rate).
+    // Unless --single-threaded is given, frame N+1 is simulated on its own thread while
+    // frame N is drawn here; SplashKit input and drawing stay on the main thread.
+    frame_stats stats;
+    player_input input = {false, false};
+    std::chrono::nanoseconds lag(0);
+    std::chrono::steady_clock::time_point previous_start = std::chrono::steady_clock::now();
+    bool first_frame = true;
+    bool quit = false;
+
+    render_snapshot front;
+    take_snapshot(game, front);
+    front.alpha = 1.0f;
+    front.input_time = previous_start;
+
+    frame_pipeline pipeline;
+    std::thread simulation;
+    if (!single_threaded)
+    {
+        take_snapshot(game, pipeline.back);
+        simulation = std::thread(run_simulation, std::ref(pipeline), std::ref(game));
+    }
+    write_line(single_threaded ? "Simulating on the main thread" : "Simulating on its own thread");
+
+    // F1 shows the profiler HUD, --profile-csv writes every frame's zone times
+    frame_profiler profiler;
+    if (!profile_csv.empty() && !start_profile_csv(profiler, profile_csv))
+    {
+        write_line("Could not write " + profile_csv);
+    }
+
+    while (!quit && front.lives > 0)
+    {
+        std::chrono::steady_clock::time_point frame_start = std::chrono::steady_clock::now();
+        lag += std::min<std::chrono::nanoseconds>(frame_start - previous_start, MAX_CATCH_UP);
+        if (!first_frame)
+        {
+            record_frame(stats, frame_start - previous_start);
+        }
+        previous_start = frame_start;
+        begin_profile_frame(profiler);
+
+        {
+            profile_scope input_zone(profile_zones(profiler), PROFILE_INPUT);
+            quit = handle_input(input);
+        }
+        if (key_typed(F1_KEY))
+        {
+            toggle_profiler_hud(profiler);
+        }
+
+        // Run as many ticks as the elapsed time covers, and draw part way between the last two
+        simulation_job job;
+        job.input = input;
+        job.ticks = static_cast<int>(lag / TICK_DURATION);
+        lag -= job.ticks * TICK_DURATION;
+        job.alpha = static_cast<float>(lag.count()) / TICK_DURATION.count();
+        job.input_time = frame_start;
+        job.profile = profiler_active(profiler);
+
+        if (single_threaded)
+        {
+            simulate_frame(game, job, front);
+        }
+        else
+        {
+            // Draw the frame simulated last time round while this one is simulated
+            submit_frame(pipeline, job);
+        }
+        {
+            profile_scope draw_zone(profile_zones(profiler), PROFILE_DRAW);
+            draw_game(front, assets, rock_sprites);
+            draw_profiler_hud(profiler, SCREEN_WIDTH - 270, 10);
+            refresh_screen();
+        }
+        add_zone_times(profiler, front.zones);
+        stats.latency_ms.push_back(std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - front.input_time).count());
+
+        if (first_frame)
+        {
+            report_startup_time("Time to interactive", program_start);
+            first_frame = false;
+        }
+        else if (assets_remaining(music) > 0)
+        {
+            // SplashKit decodes on this thread, so the music costs one frame, after the
+            // game is already playable and only once its file is in memory
+            poll_assets(music, frame_start);
+            if (assets_remaining(music) == 0)
+            {
+                play_music(music_named(BACKGROUND_MUSIC), 0.7, true);
+                report_startup_time("Time to music", program_start);
+            }
+        }
+
+        if (!single_threaded)
+        {
+            wait_for_frame(pipeline, front);
+        }
+        end_profile_frame(profiler);
+
+        if (!uncapped)
+        {
+            std::this_thread::sleep_until(frame_start + FRAME_DURATION);
+        }
+    }
+
+    if (!single_threaded)
+    {
+        stop_simulation(pipeline, simulation);
+    }
+    stats.ticks = game.tick;
+
+    if (game.lives <= 0)
+    {
+        clear_screen(COLOR_BLACK);
+
+        std::string game_over_text = "Game Over! Final Score: " + std::to_string(game.score);
+        draw_text(game_over_text,
+                  COLOR_WHITE,
+                  SCREEN_WIDTH / 2 - 100,
+                  SCREEN_HEIGHT / 2);
+        refresh_screen(60);
+
+        delay(3000);
+    }
+
+    report_frame_stats(stats);
+
+    if (assets_remaining(music) == 0)
+    {
+        stop_music();
+        free_music(music_named(BACKGROUND_MUSIC));
+    }
+    close_asset_pack(pack);
     close_window("Rock Dodge Game");
 
     return 0;
@@ -1,5 +1,16 @@
 #include "splashkit.h"
+#include "high_score_table.h"
+#include "frame_profiler.h"
 #include <vector>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+#include <cmath>
 
 // Constants for game configuration
 const int CELL_SIZE = 20;
@@ -9,7 +20,14 @@ const int WINDOW_WIDTH = GRID_WIDTH * CELL_SIZE;
 const int WINDOW_HEIGHT = GRID_HEIGHT * CELL_SIZE;
 const int INITIAL_SNAKE_LENGTH = 3;
 const int GAME_SPEED = 5; // Controls snake movement speed
-// TODO: Add a high score system
+const int MAX_SPEED = 60; // Moves per second at most, one every frame
+const uint32_t REPLAY_KEYFRAME_INTERVAL = 256; // Ticks between seek keyframes in a replay
+const uint8_t REPLAY_VERSION = 1;
+const char REPLAY_MAGIC[4] = {'S', 'N', 'K', 'R'};
+const string HIGH_SCORE_FILE = "snake-scores.dat";
+const int LEADERBOARD_SIZE = 5; // Scores shown on the game over screen
+const double HUD_X = WINDOW_WIDTH - 270; // Top left of the profiler HUD
+const double HUD_Y = 10;
 // TODO: Add a pause feature
 // TODO: Add Onyx or an other snake picture for better graphics.
 
@@ -79,6 +97,27 @@ struct Food
     Position position;
 };
 
+// Small deterministic random generator (splitmix64), so a whole game
+// can be reproduced from its seed and snapshotted in a single integer
+struct GameRng
+{
+    uint64_t state;
+
+    uint64_t next()
+    {
+        uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    // Random integer in the range [0, bound)
+    int below(int bound)
+    {
+        return static_cast<int>(next() % static_cast<uint64_t>(bound));
+    }
+};
+
 // Game state structure
 struct GameState
 {
@@ -87,6 +126,7 @@ struct GameState
     int score;
     bool gameOver;
     int speed;
+    GameRng rng;
 };
 
 // Initialize the snake
@@ -120,8 +160,8 @@ void spawnFood(GameState &gameState)
         validPosition = true;
 
         // Generate random grid position
-        int gridX = rnd(GRID_WIDTH);
-        int gridY = rnd(GRID_HEIGHT);
+        int gridX = gameState.rng.below(GRID_WIDTH);
+        int gridY = gameState.rng.below(GRID_HEIGHT);
 
         // Convert to pixel coordinates
         newPos.x = gridX * CELL_SIZE;
@@ -141,9 +181,10 @@ void spawnFood(GameState &gameState)
     gameState.food.position = newPos;
 }
 
-// Initialize the game
-void initializeGame(GameState &gameState)
+// Initialize the game from a seed; the same seed and inputs always replay the same game
+void initializeGame(GameState &gameState, uint64_t seed)
 {
+    gameState.rng.state = seed;
     gameState.score = 0;
     gameState.gameOver = false;
     gameState.speed = GAME_SPEED;
@@ -227,7 +268,7 @@ void updateGame(GameState &gameState)
         gameState.score++;
         if (gameState.score % 5 == 0)
         {                         // Every 5 points
-            gameState.speed += 1; // Increase speed by 1
+            gameState.speed = std::min(gameState.speed + 1, MAX_SPEED); // Increase speed by 1, up to the cap
         }
         spawnFood(gameState);
     }
@@ -238,35 +279,81 @@ void updateGame(GameState &gameState)
     }
 }
 
+// Draw call counters for the renderer
+struct RenderStats
+{
+    int frameDrawCalls = 0;
+    int maxDrawCalls = 0;
+    long totalDrawCalls = 0;
+    long frames = 0;
+    long fullRedraws = 0;
+};
+
+// What is currently on screen, so the next frame only redraws the cells that changed.
+// The window keeps its contents between refresh_screen calls, so untouched cells stay valid.
+struct RenderCache
+{
+    bool valid = false; // false forces a full redraw (e.g. after a reset or seek)
+    bool gameOver = false;
+    Position head;
+    Position tail;
+    Position food;
+    size_t length = 0;
+    int score = 0;
+    RenderStats stats;
+};
+
+// Draw the snake's head in a cell
+void drawHeadCell(const Position &position, RenderStats &stats)
+{
+    fill_circle(color_green(), position.x + CELL_SIZE / 2, position.y + CELL_SIZE / 2, CELL_SIZE / 2);
+    stats.frameDrawCalls++;
+}
+
+// Draw a body segment in a cell
+void drawBodyCell(const Position &position, RenderStats &stats)
+{
+    fill_rectangle(color_blue(), position.x, position.y, CELL_SIZE, CELL_SIZE);
+    stats.frameDrawCalls++;
+}
+
+// Paint a cell with the background colour
+void clearCell(const Position &position, RenderStats &stats)
+{
+    fill_rectangle(COLOR_BLACK, position.x, position.y, CELL_SIZE, CELL_SIZE);
+    stats.frameDrawCalls++;
+}
+
 // Draw the snake
-void drawSnake(const Snake &snake)
+void drawSnake(const Snake &snake, RenderStats &stats)
 {
     if (snake.segments.empty())
         return;
 
-    fill_circle(color_green(), snake.segments[0].x + CELL_SIZE / 2, snake.segments[0].y + CELL_SIZE / 2, CELL_SIZE / 2);
+    drawHeadCell(snake.segments[0], stats);
     for (size_t i = 1; i < snake.segments.size(); i++)
     {
-        const Position &segment = snake.segments[i];
-        fill_rectangle(color_blue(), segment.x, segment.y, CELL_SIZE, CELL_SIZE);
+        drawBodyCell(snake.segments[i], stats);
     }
 }
 
 // Draw the food
-void drawFood(const Food &food)
+void drawFood(const Food &food, RenderStats &stats)
 {
     fill_circle(color_red(), food.position.x + CELL_SIZE / 2, food.position.y + CELL_SIZE / 2, CELL_SIZE / 2);
+    stats.frameDrawCalls++;
 }
 
 // Draw the score
-void drawScore(int score)
+void drawScore(int score, RenderStats &stats)
 {
 
     draw_text("Score: " + std::to_string(score), color_white(), 10, 10);
+    stats.frameDrawCalls++;
 }
 
 // Draw game over screen
-void drawGameOver(int score)
+void drawGameOver(int score, const vector<high_score_record> &leaderboard, RenderStats &stats)
 {
     // TODO: Implement this function
     // Draw a game over message and the final score
@@ -274,44 +361,748 @@ void drawGameOver(int score)
     draw_text("Game Over!", color_red(), WINDOW_WIDTH / 2 - 50, WINDOW_HEIGHT / 2 - 20);
     draw_text("Final Score: " + std::to_string(score), color_white(), WINDOW_WIDTH / 2 - 50, WINDOW_HEIGHT / 2);
     draw_text("Press R to restart or Q to quit", color_white(), WINDOW_WIDTH / 2 - 100, WINDOW_HEIGHT / 2 + 20);
+    stats.frameDrawCalls += 3;
+
+    // Draw the high score leaderboard
+    for (size_t i = 0; i < leaderboard.size(); i++)
+    {
+        draw_text(std::to_string(i + 1) + ". " + leaderboard[i].name + "  " + std::to_string(leaderboard[i].score),
+                  color_white(), WINDOW_WIDTH / 2 - 50, WINDOW_HEIGHT / 2 + 50 + 15 * i);
+        stats.frameDrawCalls++;
+    }
+}
+
+// The score text sits on top of the grid in this block of cells
+const int SCORE_AREA_CELLS_X = 6;
+const int SCORE_AREA_CELLS_Y = 2;
+
+// Check if a cell lies underneath the score text
+bool inScoreArea(const Position &position)
+{
+    return position.x < SCORE_AREA_CELLS_X * CELL_SIZE && position.y < SCORE_AREA_CELLS_Y * CELL_SIZE;
+}
+
+// Repaint the cells under the score text and the text itself
+void redrawScoreArea(const GameState &gameState, RenderStats &stats)
+{
+    fill_rectangle(COLOR_BLACK, 0, 0, SCORE_AREA_CELLS_X * CELL_SIZE, SCORE_AREA_CELLS_Y * CELL_SIZE);
+    stats.frameDrawCalls++;
+
+    const vector<Position> &segments = gameState.snake.segments;
+    for (size_t i = 0; i < segments.size(); i++)
+    {
+        if (!inScoreArea(segments[i]))
+            continue;
+        if (i == 0)
+            drawHeadCell(segments[i], stats);
+        else
+            drawBodyCell(segments[i], stats);
+    }
+    if (inScoreArea(gameState.food.position))
+    {
+        drawFood(gameState.food, stats);
+    }
+    drawScore(gameState.score, stats);
+}
+
+// Check if a cell lies inside a block of whole cells
+bool inCells(const Position &position, double left, double top, double right, double bottom)
+{
+    return position.x >= left && position.x < right && position.y >= top && position.y < bottom;
 }
 
-// Render the game
-void renderGame(const GameState &gameState)
+// Repaint every cell that overlaps a rectangle of the window, covering up anything
+// drawn over the grid there (the profiler HUD)
+void redrawCells(const GameState &gameState, double x, double y, double width, double height, RenderStats &stats)
+{
+    // Widen the rectangle out to whole cells, inside the window
+    double left = std::max(0.0, std::floor(x / CELL_SIZE) * CELL_SIZE);
+    double top = std::max(0.0, std::floor(y / CELL_SIZE) * CELL_SIZE);
+    double right = std::min<double>(WINDOW_WIDTH, std::ceil((x + width) / CELL_SIZE) * CELL_SIZE);
+    double bottom = std::min<double>(WINDOW_HEIGHT, std::ceil((y + height) / CELL_SIZE) * CELL_SIZE);
+    if (left >= right || top >= bottom)
+        return;
+
+    fill_rectangle(COLOR_BLACK, left, top, right - left, bottom - top);
+    stats.frameDrawCalls++;
+
+    const vector<Position> &segments = gameState.snake.segments;
+    for (size_t i = 0; i < segments.size(); i++)
+    {
+        if (!inCells(segments[i], left, top, right, bottom))
+            continue;
+        if (i == 0)
+            drawHeadCell(segments[i], stats);
+        else
+            drawBodyCell(segments[i], stats);
+    }
+    if (inCells(gameState.food.position, left, top, right, bottom))
+    {
+        drawFood(gameState.food, stats);
+    }
+    if (left < SCORE_AREA_CELLS_X * CELL_SIZE && top < SCORE_AREA_CELLS_Y * CELL_SIZE)
+    {
+        redrawScoreArea(gameState, stats);
+    }
+}
+
+// Redraw everything from scratch
+void renderFull(const GameState &gameState, const vector<high_score_record> &leaderboard, RenderStats &stats)
 {
     clear_screen(COLOR_BLACK);
+    stats.frameDrawCalls++;
+    stats.fullRedraws++;
 
-    drawSnake(gameState.snake);
-    drawFood(gameState.food);
-    drawScore(gameState.score);
+    drawSnake(gameState.snake, stats);
+    drawFood(gameState.food, stats);
+    drawScore(gameState.score, stats);
 
     if (gameState.gameOver)
     {
-        drawGameOver(gameState.score);
+        drawGameOver(gameState.score, leaderboard, stats);
+    }
+}
+
+// Redraw only the cells that changed since the last frame: the new head, the old head
+// (now a body segment), the vacated tail and the food. Everything else is left as is.
+void renderChanges(const GameState &gameState, const RenderCache &cache, RenderStats &stats)
+{
+    const vector<Position> &segments = gameState.snake.segments;
+    const Position &head = segments[0];
+    bool scoreDirty = gameState.score != cache.score;
+
+    if (!(head == cache.head))
+    {
+        // Clear the tail first, the new head may have moved into it
+        if (!(segments.back() == cache.tail))
+        {
+            clearCell(cache.tail, stats);
+        }
+        if (segments.size() > 1)
+        {
+            drawBodyCell(cache.head, stats);
+        }
+        clearCell(head, stats);
+        drawHeadCell(head, stats);
+
+        scoreDirty = scoreDirty || inScoreArea(cache.tail) || inScoreArea(cache.head) || inScoreArea(head);
+    }
+
+    if (!(gameState.food.position == cache.food))
+    {
+        drawFood(gameState.food, stats);
+        scoreDirty = scoreDirty || inScoreArea(gameState.food.position);
+    }
+
+    if (scoreDirty)
+    {
+        redrawScoreArea(gameState, stats);
+    }
+}
+
+// Check if the snake moved at most one cell since the cached frame
+bool movedAtMostOneCell(const Snake &snake, const RenderCache &cache)
+{
+    return snake.segments[0] == cache.head ||
+           (snake.segments.size() > 1 && snake.segments[1] == cache.head);
+}
+
+// Render the game, falling back to a full redraw only when the cache is invalid,
+// the game has just ended, or the snake was reset or moved more than one cell
+void renderGame(const GameState &gameState, const vector<high_score_record> &leaderboard, RenderCache &cache)
+{
+    RenderStats &stats = cache.stats;
+    stats.frameDrawCalls = 0;
+
+    if (!cache.valid || gameState.gameOver != cache.gameOver ||
+        gameState.snake.segments.size() < cache.length ||
+        !movedAtMostOneCell(gameState.snake, cache))
+    {
+        renderFull(gameState, leaderboard, stats);
+    }
+    else if (!gameState.gameOver)
+    {
+        renderChanges(gameState, cache, stats);
+    }
+
+    cache.valid = true;
+    cache.gameOver = gameState.gameOver;
+    cache.head = gameState.snake.segments.front();
+    cache.tail = gameState.snake.segments.back();
+    cache.food = gameState.food.position;
+    cache.length = gameState.snake.segments.size();
+    cache.score = gameState.score;
+
+    stats.frames++;
+    stats.totalDrawCalls += stats.frameDrawCalls;
+    stats.maxDrawCalls = std::max(stats.maxDrawCalls, stats.frameDrawCalls);
+}
+
+// Print how many draw calls the renderer issued per frame
+void reportRenderStats(const RenderStats &stats)
+{
+    if (stats.frames == 0)
+        return;
+
+    write_line("Frames rendered: " + std::to_string(stats.frames) +
+               " (" + std::to_string(stats.fullRedraws) + " full redraws)");
+    write_line("Draw calls per frame: average " +
+               std::to_string(static_cast<double>(stats.totalDrawCalls) / stats.frames) +
+               ", max " + std::to_string(stats.maxDrawCalls));
+}
+
+// ---------------------------------------------------------------------------
+// Replays
+//
+// A replay stores the seed plus only the ticks where the direction changed.
+// Everything else is re-simulated by updateGame. Full state keyframes are
+// stored every REPLAY_KEYFRAME_INTERVAL ticks so playback can seek quickly.
+//
+// File layout (all integers are LEB128 varints):
+//   "SNKR" version seed tickCount finalScore keyframeInterval
+//   inputCount  { (tickDelta << 2) | direction }...
+//   keyframeCount { tick inputIndex state }...
+// ---------------------------------------------------------------------------
+
+// A direction change applied just before the given tick runs
+struct ReplayInput
+{
+    uint32_t tick;
+    Direction direction;
+};
+
+// Game state after `tick` ticks, with the index of the next input to apply
+struct ReplayKeyframe
+{
+    uint32_t tick;
+    uint32_t inputIndex;
+    GameState state;
+};
+
+// A complete recorded game
+struct Replay
+{
+    uint64_t seed = 0;
+    uint32_t tickCount = 0;
+    int finalScore = 0;
+    vector<ReplayInput> inputs;
+    vector<ReplayKeyframe> keyframes;
+};
+
+// Records the inputs of a game as it is played
+struct ReplayRecorder
+{
+    Replay replay;
+    Direction lastDirection;
+};
+
+// Plays a replay back by re-simulating it
+struct ReplayPlayer
+{
+    const Replay *replay;
+    GameState state;
+    uint32_t tick;
+    size_t nextInput;
+};
+
+// Append an unsigned integer as a LEB128 varint
+void writeVarint(vector<uint8_t> &out, uint64_t value)
+{
+    while (value >= 0x80)
+    {
+        out.push_back(static_cast<uint8_t>(value) | 0x80);
+        value >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+// Read a LEB128 varint, returns false if the data ends early
+bool readVarint(const uint8_t *&cursor, const uint8_t *end, uint64_t &value)
+{
+    value = 0;
+    for (int shift = 0; shift < 64 && cursor < end; shift += 7)
+    {
+        uint8_t byte = *cursor++;
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+    return false;
+}
+
+// Encode a game state, positions are stored as grid cells
+void writeState(vector<uint8_t> &out, const GameState &gameState)
+{
+    writeVarint(out, gameState.rng.state);
+    writeVarint(out, gameState.snake.direction);
+    writeVarint(out, gameState.score);
+    writeVarint(out, gameState.speed);
+    writeVarint(out, gameState.gameOver ? 1 : 0);
+    writeVarint(out, static_cast<uint64_t>(gameState.food.position.x / CELL_SIZE));
+    writeVarint(out, static_cast<uint64_t>(gameState.food.position.y / CELL_SIZE));
+    writeVarint(out, gameState.snake.segments.size());
+    for (const Position &segment : gameState.snake.segments)
+    {
+        writeVarint(out, static_cast<uint64_t>(segment.x / CELL_SIZE));
+        writeVarint(out, static_cast<uint64_t>(segment.y / CELL_SIZE));
+    }
+}
+
+// Decode a game state written by writeState
+bool readState(const uint8_t *&cursor, const uint8_t *end, GameState &gameState)
+{
+    uint64_t direction, score, speed, gameOver, foodX, foodY, length;
+    if (!readVarint(cursor, end, gameState.rng.state) ||
+        !readVarint(cursor, end, direction) || direction > RIGHT ||
+        !readVarint(cursor, end, score) ||
+        !readVarint(cursor, end, speed) || speed == 0 || speed > MAX_SPEED ||
+        !readVarint(cursor, end, gameOver) ||
+        !readVarint(cursor, end, foodX) ||
+        !readVarint(cursor, end, foodY) ||
+        !readVarint(cursor, end, length) || length > GRID_WIDTH * GRID_HEIGHT)
+        return false;
+
+    gameState.snake.direction = static_cast<Direction>(direction);
+    gameState.score = static_cast<int>(score);
+    gameState.speed = static_cast<int>(speed);
+    gameState.gameOver = gameOver != 0;
+    gameState.food.position = {static_cast<double>(foodX * CELL_SIZE), static_cast<double>(foodY * CELL_SIZE)};
+
+    gameState.snake.segments.resize(length);
+    for (Position &segment : gameState.snake.segments)
+    {
+        uint64_t x, y;
+        if (!readVarint(cursor, end, x) || !readVarint(cursor, end, y))
+            return false;
+        segment = {static_cast<double>(x * CELL_SIZE), static_cast<double>(y * CELL_SIZE)};
+    }
+    return true;
+}
+
+// Write a replay to disk, returns false on failure
+bool saveReplay(const string &path, const Replay &replay)
+{
+    vector<uint8_t> out(REPLAY_MAGIC, REPLAY_MAGIC + sizeof(REPLAY_MAGIC));
+    out.push_back(REPLAY_VERSION);
+    writeVarint(out, replay.seed);
+    writeVarint(out, replay.tickCount);
+    writeVarint(out, replay.finalScore);
+    writeVarint(out, REPLAY_KEYFRAME_INTERVAL);
+
+    writeVarint(out, replay.inputs.size());
+    uint32_t previousTick = 0;
+    for (const ReplayInput &input : replay.inputs)
+    {
+        writeVarint(out, (static_cast<uint64_t>(input.tick - previousTick) << 2) | input.direction);
+        previousTick = input.tick;
+    }
+
+    writeVarint(out, replay.keyframes.size());
+    for (const ReplayKeyframe &keyframe : replay.keyframes)
+    {
+        writeVarint(out, keyframe.tick);
+        writeVarint(out, keyframe.inputIndex);
+        writeState(out, keyframe.state);
+    }
+
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char *>(out.data()), out.size());
+    return static_cast<bool>(file);
+}
+
+// Read a replay from disk, returns false if it is missing or malformed
+bool loadReplay(const string &path, Replay &replay)
+{
+    std::ifstream file(path, std::ios::binary);
+    vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (data.size() < sizeof(REPLAY_MAGIC) + 1 ||
+        std::memcmp(data.data(), REPLAY_MAGIC, sizeof(REPLAY_MAGIC)) != 0 ||
+        data[sizeof(REPLAY_MAGIC)] != REPLAY_VERSION)
+        return false;
+
+    const uint8_t *cursor = data.data() + sizeof(REPLAY_MAGIC) + 1;
+    const uint8_t *end = data.data() + data.size();
+    uint64_t tickCount, finalScore, interval, inputCount, keyframeCount;
+    if (!readVarint(cursor, end, replay.seed) ||
+        !readVarint(cursor, end, tickCount) ||
+        !readVarint(cursor, end, finalScore) ||
+        !readVarint(cursor, end, interval) ||
+        !readVarint(cursor, end, inputCount) || inputCount > tickCount)
+        return false;
+
+    replay.tickCount = static_cast<uint32_t>(tickCount);
+    replay.finalScore = static_cast<int>(finalScore);
+    replay.inputs.clear();
+    replay.inputs.reserve(inputCount);
+    uint64_t tick = 0;
+    for (uint64_t i = 0; i < inputCount; i++)
+    {
+        uint64_t packed;
+        if (!readVarint(cursor, end, packed))
+            return false;
+        tick += packed >> 2;
+        replay.inputs.push_back({static_cast<uint32_t>(tick), static_cast<Direction>(packed & 3)});
+    }
+
+    if (!readVarint(cursor, end, keyframeCount) || keyframeCount > tickCount)
+        return false;
+    replay.keyframes.clear();
+    replay.keyframes.reserve(keyframeCount);
+    for (uint64_t i = 0; i < keyframeCount; i++)
+    {
+        uint64_t keyframeTick, inputIndex;
+        ReplayKeyframe keyframe;
+        if (!readVarint(cursor, end, keyframeTick) ||
+            !readVarint(cursor, end, inputIndex) || inputIndex > inputCount ||
+            !readState(cursor, end, keyframe.state))
+            return false;
+        keyframe.tick = static_cast<uint32_t>(keyframeTick);
+        keyframe.inputIndex = static_cast<uint32_t>(inputIndex);
+        replay.keyframes.push_back(std::move(keyframe));
+    }
+    return true;
+}
+
+// Begin recording a game that was just initialized from `seed`
+void startRecording(ReplayRecorder &recorder, const GameState &gameState, uint64_t seed)
+{
+    recorder.replay = Replay();
+    recorder.replay.seed = seed;
+    recorder.lastDirection = gameState.snake.direction;
+}
+
+// Run one tick of the game, recording its input and any keyframe that is due
+void recordTick(ReplayRecorder &recorder, GameState &gameState)
+{
+    Replay &replay = recorder.replay;
+    if (gameState.snake.direction != recorder.lastDirection)
+    {
+        replay.inputs.push_back({replay.tickCount, gameState.snake.direction});
+        recorder.lastDirection = gameState.snake.direction;
+    }
+
+    updateGame(gameState);
+    replay.tickCount++;
+    replay.finalScore = gameState.score;
+
+    if (replay.tickCount % REPLAY_KEYFRAME_INTERVAL == 0)
+    {
+        replay.keyframes.push_back({replay.tickCount, static_cast<uint32_t>(replay.inputs.size()), gameState});
+    }
+}
+
+// Reset playback to the start of the replay
+void startPlayback(ReplayPlayer &player, const Replay &replay)
+{
+    player.replay = &replay;
+    initializeGame(player.state, replay.seed);
+    player.tick = 0;
+    player.nextInput = 0;
+}
+
+// Advance playback by one tick, returns false once the replay has ended
+bool stepPlayback(ReplayPlayer &player)
+{
+    const Replay &replay = *player.replay;
+    if (player.tick >= replay.tickCount)
+        return false;
+
+    if (player.nextInput < replay.inputs.size() && replay.inputs[player.nextInput].tick == player.tick)
+    {
+        player.state.snake.direction = replay.inputs[player.nextInput].direction;
+        player.nextInput++;
+    }
+
+    updateGame(player.state);
+    player.tick++;
+    return true;
+}
+
+// Jump to the given tick, restoring the nearest earlier keyframe and simulating the rest
+void seekPlayback(ReplayPlayer &player, uint32_t targetTick)
+{
+    const Replay &replay = *player.replay;
+    targetTick = std::min(targetTick, replay.tickCount);
+
+    auto keyframe = std::upper_bound(replay.keyframes.begin(), replay.keyframes.end(), targetTick,
+                                     [](uint32_t tick, const ReplayKeyframe &k)
+                                     { return tick < k.tick; });
+
+    // Use the keyframe when seeking backwards or when it lies ahead of the current tick
+    bool rewinding = targetTick < player.tick;
+    if (keyframe != replay.keyframes.begin() && (rewinding || (keyframe - 1)->tick > player.tick))
+    {
+        --keyframe;
+        player.state = keyframe->state;
+        player.tick = keyframe->tick;
+        player.nextInput = keyframe->inputIndex;
+    }
+    else if (rewinding)
+    {
+        startPlayback(player, replay);
+    }
+
+    while (player.tick < targetTick && stepPlayback(player))
+    {
+    }
+}
+
+// Re-simulate a replay headlessly as fast as possible and check it reproduces the recorded result
+bool validateReplay(const Replay &replay)
+{
+    const uint64_t MIN_BENCHMARK_TICKS = 1000000;
+    ReplayPlayer player;
+    uint64_t totalTicks = 0;
+    int passes = 0;
+    bool valid = true;
+
+    auto start = std::chrono::steady_clock::now();
+    do
+    {
+        startPlayback(player, replay);
+        while (stepPlayback(player))
+        {
+        }
+        totalTicks += player.tick;
+        passes++;
+        valid = valid && player.state.score == replay.finalScore;
+    } while (totalTicks < MIN_BENCHMARK_TICKS && replay.tickCount > 0);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    write_line("Replay: " + std::to_string(replay.tickCount) + " ticks, " +
+               std::to_string(replay.inputs.size()) + " inputs, final score " + std::to_string(replay.finalScore));
+    write_line("Simulated score: " + std::to_string(player.state.score) + (valid ? " (valid)" : " (MISMATCH)"));
+    if (seconds > 0)
+    {
+        write_line("Playback speed: " + std::to_string(static_cast<uint64_t>(totalTicks / seconds)) +
+                   " ticks/s over " + std::to_string(passes) + " passes");
+    }
+    return valid;
+}
+
+// Watch a replay in a window, `playbackSpeed` ticks run for every tick of normal play.
+// LEFT/RIGHT jump back/forward by one keyframe interval.
+void watchReplay(const Replay &replay, double playbackSpeed, uint32_t startTick)
+{
+    open_window("Snake Replay", WINDOW_WIDTH, WINDOW_HEIGHT);
+
+    ReplayPlayer player;
+    startPlayback(player, replay);
+    seekPlayback(player, startTick);
+    RenderCache renderCache;
+
+    int frameCount = 0;
+    double tickBudget = 0;
+
+    while (!quit_requested() && !key_down(Q_KEY))
+    {
+        process_events();
+
+        if (key_typed(LEFT_KEY))
+        {
+            seekPlayback(player, player.tick > REPLAY_KEYFRAME_INTERVAL ? player.tick - REPLAY_KEYFRAME_INTERVAL : 0);
+            renderCache.valid = false;
+        }
+        else if (key_typed(RIGHT_KEY))
+        {
+            seekPlayback(player, player.tick + REPLAY_KEYFRAME_INTERVAL);
+            renderCache.valid = false;
+        }
+
+        frameCount++;
+        if (frameCount >= 60 / player.state.speed)
+        {
+            tickBudget += playbackSpeed;
+            while (tickBudget >= 1 && stepPlayback(player))
+            {
+                tickBudget--;
+            }
+            frameCount = 0;
+        }
+
+        renderGame(player.state, {}, renderCache);
+        refresh_screen(60);
+    }
+
+    close_window("Snake Replay");
+    reportRenderStats(renderCache.stats);
+}
+
+// Save the recorded game as snake-<seed>.replay
+void finishRecording(const ReplayRecorder &recorder)
+{
+    if (recorder.replay.tickCount == 0)
+        return;
+
+    string path = "snake-" + std::to_string(recorder.replay.seed) + ".replay";
+    if (!saveReplay(path, recorder.replay))
+    {
+        write_line("Could not save replay to " + path);
+    }
+}
+
+// Add a finished game to the high score file and return the new leaderboard
+vector<high_score_record> recordScore(high_score_table &scores, const Replay &replay)
+{
+    // A table that failed to open was reported once at startup
+    if (!scores.header)
+        return {};
+
+    const char *user = std::getenv("USER");
+    if (!record_high_score(scores, user ? user : "player", replay.finalScore, replay.tickCount, replay.seed))
+    {
+        write_line("Could not save score to " + HIGH_SCORE_FILE);
+    }
+    return top_high_scores(scores, LEADERBOARD_SIZE);
+}
+
+// Print the best scores recorded in the high score file
+void printHighScores(high_score_table &scores)
+{
+    write_line(std::to_string(high_score_count(scores)) + " games recorded");
+    vector<high_score_record> leaderboard = top_high_scores(scores, 10);
+    for (size_t i = 0; i < leaderboard.size(); i++)
+    {
+        write_line(std::to_string(i + 1) + ". " + leaderboard[i].name + " " + std::to_string(leaderboard[i].score) +
+                   " (seed " + std::to_string(leaderboard[i].seed) + ")");
     }
 }
 
 // Main function
-int main()
+//
+// Usage: snake                                       play (every game is recorded)
+//        snake --scores                              print the high score table
+//        snake --replay <file> [--speed <x>] [--seek <tick>]   watch a replay
+//        snake --replay <file> --speed max           validate a replay headlessly
+int main(int argc, char *argv[])
 {
+    string replayPath;
+    double playbackSpeed = 1.0;
+    bool headless = false;
+    bool showScores = false;
+    uint32_t seekTick = 0;
+    string profileCsv;
+
+    for (int i = 1; i < argc; i++)
+    {
+        string option = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (option == "--scores")
+        {
+            showScores = true;
+        }
+        else if (option == "--replay" && hasValue)
+        {
+            replayPath = argv[++i];
+        }
+        else if (option == "--speed" && hasValue)
+        {
+            string value = argv[++i];
+            if (value == "max")
+                headless = true;
+            else
+                playbackSpeed = std::stod(value);
+        }
+        else if (option == "--seek" && hasValue)
+        {
+            seekTick = static_cast<uint32_t>(std::stoul(argv[++i]));
+        }
+        else if (option == "--profile-csv" && hasValue)
+        {
+            profileCsv = argv[++i];
+        }
+    }
+
+    if (!replayPath.empty())
+    {
+        Replay replay;
+        if (!loadReplay(replayPath, replay))
+        {
+            write_line("Could not read replay " + replayPath);
+            return 1;
+        }
+        if (headless)
+        {
+            return validateReplay(replay) ? 0 : 1;
+        }
+        watchReplay(replay, playbackSpeed, seekTick);
+        return 0;
+    }
+
+    high_score_table scores;
+    if (!open_high_score_table(scores, HIGH_SCORE_FILE))
+    {
+        if (showScores)
+        {
+            write_line("Could not open " + HIGH_SCORE_FILE);
+            return 1;
+        }
+        write_line("Could not open " + HIGH_SCORE_FILE + ", scores will not be saved");
+    }
+
+    if (showScores)
+    {
+        printHighScores(scores);
+        close_high_score_table(scores);
+        return 0;
+    }
+
     // Create the game window
     open_window("Snake Game", WINDOW_WIDTH, WINDOW_HEIGHT);
 
-    // Initialize game state
+    // Initialize game state, recording from the start
+    std::random_device seedSource;
+    uint64_t seed = (static_cast<uint64_t>(seedSource()) << 32) | seedSource();
     GameState gameState;
-    initializeGame(gameState);
+    initializeGame(gameState, seed);
+
+    ReplayRecorder recorder;
+    startRecording(recorder, gameState, seed);
+    bool replaySaved = false;
+
+    RenderCache renderCache;
+    vector<high_score_record> leaderboard;
+
+    // F1 shows the profiler HUD, --profile-csv writes every frame's zone times
+    frame_profiler profiler;
+    if (!profileCsv.empty() && !start_profile_csv(profiler, profileCsv))
+    {
+        write_line("Could not write " + profileCsv);
+    }
 
     // Main game loop
     int frameCount = 0;
 
     while (!quit_requested())
     {
-        process_events();
+        begin_profile_frame(profiler);
+        {
+            profile_scope inputZone(profile_zones(profiler), PROFILE_INPUT);
+            process_events();
+        }
+        bool hudToggled = key_typed(F1_KEY);
+        if (hudToggled)
+        {
+            toggle_profiler_hud(profiler);
+        }
+
         if (gameState.gameOver)
         {
+            if (!replaySaved)
+            {
+                finishRecording(recorder);
+                leaderboard = recordScore(scores, recorder.replay);
+                replaySaved = true;
+                renderCache.valid = false;
+            }
+
             if (key_down(R_KEY))
             {
-                initializeGame(gameState);
+                seed = (static_cast<uint64_t>(seedSource()) << 32) | seedSource();
+                initializeGame(gameState, seed);
+                startRecording(recorder, gameState, seed);
+                replaySaved = false;
+                renderCache.valid = false;
             }
             else if (key_down(Q_KEY))
             {
@@ -320,21 +1111,48 @@ int main()
         }
         else
         {
-
-            handleInput(gameState);
+            {
+                profile_scope inputZone(profile_zones(profiler), PROFILE_INPUT);
+                handleInput(gameState);
+            }
 
             // Update game at a controlled rate
             frameCount++;
             if (frameCount >= 60 / gameState.speed)
             {
-                updateGame(gameState);
+                profile_scope updateZone(profile_zones(profiler), PROFILE_UPDATE);
+                recordTick(recorder, gameState);
                 frameCount = 0;
             }
         }
 
-        renderGame(gameState);
+        {
+            profile_scope drawZone(profile_zones(profiler), PROFILE_DRAW);
+            // The HUD is see-through, so the cells under it are repainted before it is drawn
+            // again, and once more when it is hidden. The game over text is redrawn in full.
+            bool hudDirty = profiler.hud_visible || hudToggled;
+            if (hudDirty && gameState.gameOver)
+            {
+                renderCache.valid = false;
+            }
+            renderGame(gameState, leaderboard, renderCache);
+            if (hudDirty && !gameState.gameOver)
+            {
+                redrawCells(gameState, HUD_X, HUD_Y, PROFILER_HUD_WIDTH, PROFILER_HUD_HEIGHT, renderCache.stats);
+            }
+            draw_profiler_hud(profiler, HUD_X, HUD_Y);
+        }
+        end_profile_frame(profiler);
         refresh_screen(60);
     }
 
+    if (!replaySaved)
+    {
+        finishRecording(recorder);
+    }
+    close_high_score_table(scores);
+
+    reportRenderStats(renderCache.stats);
+
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,181 @@
+#include "stats_groups.h"
+
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+    const size_t MIN_SLOTS = 1024;
+
+    // 64-bit FNV-1a
+    uint64_t hash_key(const char *key, size_t length)
+    {
+        uint64_t hash = 14695981039346656037ull;
+        for (size_t i = 0; i < length; i++)
+        {
+            hash = (hash ^ static_cast<unsigned char>(key[i])) * 1099511628211ull;
+        }
+        return hash;
+    }
+
+    // The capacity an array grows to when it must hold needed items, doubling as the
+    // standard containers do. add_group reserves exactly this, so the budget sees it.
+    size_t grown_capacity(size_t capacity, size_t needed)
+    {
+        return needed <= capacity ? capacity : std::max(needed, capacity * 2);
+    }
+
+    // Bytes the table's arrays will have allocated, spare capacity included, once
+    // they hold some more groups and key bytes
+    size_t bytes_with(const group_table &table, size_t groups, size_t key_length)
+    {
+        size_t count = table.key_hash.size() + groups;
+        size_t slots = table.slots.size();
+        while (count * 2 > slots)
+        {
+            slots *= 2;
+        }
+
+        size_t bytes = slots * sizeof(group_slot) +
+                       grown_capacity(table.key_bytes.capacity(), table.key_bytes.size() + key_length) +
+                       grown_capacity(table.keys.capacity(), count) * sizeof(key_span) +
+                       grown_capacity(table.key_hash.capacity(), count) * sizeof(uint64_t);
+        for (const vector<column_stats> &column : table.columns)
+        {
+            bytes += grown_capacity(column.capacity(), count) * sizeof(column_stats);
+        }
+        return bytes;
+    }
+
+    void place(vector<group_slot> &slots, uint64_t hash, uint32_t group)
+    {
+        size_t mask = slots.size() - 1;
+        size_t slot = hash & mask;
+        while (slots[slot].group != 0)
+        {
+            slot = (slot + 1) & mask;
+        }
+        slots[slot] = {static_cast<uint32_t>(hash >> 32), group + 1};
+    }
+
+    void grow_slots(group_table &table)
+    {
+        vector<group_slot> slots(table.slots.size() * 2, group_slot{0, 0});
+        for (uint32_t group = 0; group < table.key_hash.size(); group++)
+        {
+            place(slots, table.key_hash[group], group);
+        }
+        table.slots.swap(slots);
+    }
+
+    uint32_t add_group(group_table &table, const char *key, size_t length, uint64_t hash)
+    {
+        uint32_t group = static_cast<uint32_t>(table.key_hash.size());
+        size_t count = table.key_hash.size() + 1;
+        table.keys.reserve(grown_capacity(table.keys.capacity(), count));
+        table.key_hash.reserve(grown_capacity(table.key_hash.capacity(), count));
+        table.key_bytes.reserve(grown_capacity(table.key_bytes.capacity(), table.key_bytes.size() + length));
+        table.keys.push_back({static_cast<uint32_t>(table.key_bytes.size()), static_cast<uint32_t>(length)});
+        table.key_hash.push_back(hash);
+        table.key_bytes.append(key, length);
+
+        for (vector<column_stats> &column : table.columns)
+        {
+            column.reserve(grown_capacity(column.capacity(), count));
+            column.push_back({0, 0, std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity()});
+        }
+
+        table.memory_used = bytes_with(table, 0, 0);
+        place(table.slots, hash, group);
+        return group;
+    }
+
+    uint32_t other_group(group_table &table)
+    {
+        if (table.other_group < 0)
+        {
+            table.other_group = add_group(table, OTHER_GROUP_KEY.data(), OTHER_GROUP_KEY.size(),
+                                          hash_key(OTHER_GROUP_KEY.data(), OTHER_GROUP_KEY.size()));
+        }
+        return static_cast<uint32_t>(table.other_group);
+    }
+}
+
+void init_group_table(group_table &table, size_t column_count, size_t memory_budget)
+{
+    table = group_table();
+    table.memory_budget = memory_budget;
+    table.columns.resize(column_count);
+    table.slots.assign(MIN_SLOTS, group_slot{0, 0});
+    table.memory_used = bytes_with(table, 0, 0);
+}
+
+uint32_t find_group(group_table &table, const char *key, size_t length)
+{
+    uint64_t hash = hash_key(key, length);
+    uint32_t tag = static_cast<uint32_t>(hash >> 32);
+    size_t mask = table.slots.size() - 1;
+    for (size_t slot = hash & mask; table.slots[slot].group != 0; slot = (slot + 1) & mask)
+    {
+        // Only a matching tag is worth the trip to the key itself
+        if (table.slots[slot].tag != tag)
+            continue;
+
+        uint32_t group = table.slots[slot].group - 1;
+        const key_span &span = table.keys[group];
+        if (span.length == length && table.key_bytes.compare(span.start, length, key, length) == 0)
+        {
+            return group;
+        }
+    }
+
+    // A real key spelled like the overflow group would be merged into it
+    if (length == OTHER_GROUP_KEY.size() && OTHER_GROUP_KEY.compare(0, length, key, length) == 0)
+        return other_group(table);
+
+    // A new key: it has to fit, along with however much its arrays grow by and,
+    // until it exists, the overflow group that takes the rows once nothing else fits.
+    // The slots are kept at most half full so probe runs stay short.
+    bool needs_growth = (table.key_hash.size() + 1) * 2 > table.slots.size();
+    bool reserve_other = table.other_group < 0;
+    size_t needed = bytes_with(table, reserve_other ? 2 : 1, length + (reserve_other ? OTHER_GROUP_KEY.size() : 0));
+    if (needed > table.memory_budget ||
+        table.key_bytes.size() + length > std::numeric_limits<uint32_t>::max())
+    {
+        table.folded_rows++;
+        return other_group(table);
+    }
+
+    if (needs_growth)
+    {
+        grow_slots(table);
+    }
+    return add_group(table, key, length, hash);
+}
+
+void prefetch_group(const group_table &table, uint32_t group)
+{
+    for (const vector<column_stats> &column : table.columns)
+    {
+        __builtin_prefetch(&column[group], 1);
+    }
+}
+
+void add_group_value(group_table &table, uint32_t group, size_t column, double value)
+{
+    column_stats &stats = table.columns[column][group];
+    stats.count++;
+    stats.total += value;
+    stats.min = std::min(stats.min, value);
+    stats.max = std::max(stats.max, value);
+}
+
+size_t group_count(const group_table &table)
+{
+    return table.key_hash.size();
+}
+
+string group_key(const group_table &table, uint32_t group)
+{
+    return table.key_bytes.substr(table.keys[group].start, table.keys[group].length);
+}
@@ -0,0 +1,143 @@
+#ifndef STATS_GROUPS_H
+#define STATS_GROUPS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+using std::string;
+using std::vector;
+
+// Memory a group table may use before new keys are folded into OTHER_GROUP_KEY
+const size_t DEFAULT_GROUP_MEMORY = size_t(512) << 20;
+
+// Key of the group that collects rows once the memory budget is spent
+const string OTHER_GROUP_KEY = "(other)";
+
+/**
+ * The statistics of one numeric column in one group. A column keeps these
+ * for every group in one array, so each value added touches one small
+ * block of memory however many statistics there are.
+ *
+ * @field count how many values
+ * @field total sum of the values
+ * @field min   smallest value
+ * @field max   largest value
+ */
+struct column_stats
+{
+    uint64_t count;
+    double total;
+    double min;
+    double max;
+};
+
+/**
+ * One slot of a group table's hash table.
+ *
+ * @field tag   top half of the key's hash, checked before the key itself
+ * @field group group number + 1, or 0 if the slot is empty
+ */
+struct group_slot
+{
+    uint32_t tag;
+    uint32_t group;
+};
+
+/**
+ * Where a group's key is in the table's key buffer.
+ *
+ * @field start  offset of the first character
+ * @field length how many characters
+ */
+struct key_span
+{
+    uint32_t start;
+    uint32_t length;
+};
+
+/**
+ * Per group, per column statistics keyed by strings. Keys are interned
+ * once into a single buffer and looked up through an open addressing
+ * (linear probing) table of group numbers. When adding a group would take
+ * the table over its memory budget, the row goes to OTHER_GROUP_KEY.
+ *
+ * @field memory_budget bytes the table may use
+ * @field memory_used   bytes the table has allocated, spare capacity included
+ * @field slots         the hash table, a power of two in size
+ * @field key_bytes     every key, end to end
+ * @field keys          where each group's key is in key_bytes
+ * @field key_hash      hash of each group's key, to rebuild the slots
+ * @field columns       the statistics of each numeric column, indexed by group
+ * @field other_group   number of the OTHER_GROUP_KEY group, or -1 if unused
+ * @field folded_rows   rows folded into OTHER_GROUP_KEY because the budget was spent
+ */
+struct group_table
+{
+    size_t memory_budget = DEFAULT_GROUP_MEMORY;
+    size_t memory_used = 0;
+    vector<group_slot> slots;
+    string key_bytes;
+    vector<key_span> keys;
+    vector<uint64_t> key_hash;
+    vector<vector<column_stats>> columns;
+    int64_t other_group = -1;
+    uint64_t folded_rows = 0;
+};
+
+/**
+ * Set up an empty group table.
+ *
+ * @param table         the table
+ * @param column_count  how many numeric columns each group has
+ * @param memory_budget bytes the table may use
+ */
+void init_group_table(group_table &table, size_t column_count, size_t memory_budget);
+
+/**
+ * Find the group for a key, adding it if it is new.
+ *
+ * @param table  the table
+ * @param key    the key's characters
+ * @param length how many characters
+ * @returns the group number
+ */
+uint32_t find_group(group_table &table, const char *key, size_t length);
+
+/**
+ * Start loading a group's statistics into the cache, so the misses overlap
+ * with parsing the rest of the row rather than stalling add_group_value.
+ *
+ * @param table the table
+ * @param group the group number, from find_group
+ */
+void prefetch_group(const group_table &table, uint32_t group);
+
+/**
+ * Add a value to one column of a group.
+ *
+ * @param table  the table
+ * @param group  the group number, from find_group
+ * @param column the column number
+ * @param value  the value to add
+ */
+void add_group_value(group_table &table, uint32_t group, size_t column, double value);
+
+/**
+ * Count the groups in a table.
+ *
+ * @param table the table
+ * @returns the number of groups
+ */
+size_t group_count(const group_table &table);
+
+/**
+ * The key of a group.
+ *
+ * @param table the table
+ * @param group the group number
+ * @returns the key
+ */
+string group_key(const group_table &table, uint32_t group);
+
+#endif
@@ -0,0 +1,257 @@
+#include "stats_sketches.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace
+{
+    const int MIN_PRECISION = 4;
+    const int MAX_PRECISION = 18;
+
+    // Every zero and every NaN count as one value
+    uint64_t value_key(double value)
+    {
+        if (value == 0)
+            value = 0;
+        if (std::isnan(value))
+            value = std::numeric_limits<double>::quiet_NaN();
+
+        uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        return bits;
+    }
+
+    // splitmix64's finaliser: every input bit affects every output bit
+    uint64_t mix(uint64_t x)
+    {
+        x ^= x >> 30;
+        x *= 0xBF58476D1CE4E5B9ull;
+        x ^= x >> 27;
+        x *= 0x94D049BB133111EBull;
+        x ^= x >> 31;
+        return x;
+    }
+
+    // Row i of a Count-Min sketch uses h1 + i * h2 (Kirsch-Mitzenmacher)
+    size_t count_min_column(const count_min_sketch &sketch, uint64_t hash, size_t row)
+    {
+        uint64_t h1 = hash;
+        uint64_t h2 = (hash >> 32) | 1;
+        return static_cast<size_t>((h1 + row * h2) & (sketch.width - 1));
+    }
+
+    void swap_entries(top_values &top, size_t a, size_t b)
+    {
+        std::swap(top.heap[a], top.heap[b]);
+        top.position[top.heap[a].key] = a;
+        top.position[top.heap[b].key] = b;
+    }
+
+    // Move an entry down after its count went up
+    void sift_down(top_values &top, size_t index)
+    {
+        while (true)
+        {
+            size_t smallest = index;
+            for (size_t child = 2 * index + 1; child <= 2 * index + 2 && child < top.heap.size(); child++)
+            {
+                if (top.heap[child].count < top.heap[smallest].count)
+                    smallest = child;
+            }
+            if (smallest == index)
+                return;
+            swap_entries(top, index, smallest);
+            index = smallest;
+        }
+    }
+
+    void sift_up(top_values &top, size_t index)
+    {
+        while (index > 0 && top.heap[index].count < top.heap[(index - 1) / 2].count)
+        {
+            swap_entries(top, index, (index - 1) / 2);
+            index = (index - 1) / 2;
+        }
+    }
+
+    void count_key(top_values &top, uint64_t key, uint64_t count, uint64_t error)
+    {
+        std::unordered_map<uint64_t, size_t>::iterator found = top.position.find(key);
+        if (found != top.position.end())
+        {
+            top.heap[found->second].count += count;
+            top.heap[found->second].error += error;
+            sift_down(top, found->second);
+        }
+        else if (top.heap.size() < top.capacity)
+        {
+            top.heap.push_back({key, count, error});
+            top.position[key] = top.heap.size() - 1;
+            sift_up(top, top.heap.size() - 1);
+        }
+        else
+        {
+            // Replace the least counted value, which may have been this one all along
+            frequent_value &least = top.heap[0];
+            top.position.erase(least.key);
+            least = {key, least.count + count, least.count + error};
+            top.position[key] = 0;
+            sift_down(top, 0);
+        }
+    }
+}
+
+void init_distinct_counter(distinct_counter &counter, double relative_error)
+{
+    double registers = std::pow(1.04 / std::max(relative_error, 1e-6), 2);
+    counter.precision = std::min(std::max(static_cast<int>(std::ceil(std::log2(registers))), MIN_PRECISION), MAX_PRECISION);
+    counter.registers.assign(size_t(1) << counter.precision, 0);
+}
+
+void distinct_add(distinct_counter &counter, double value)
+{
+    uint64_t hash = mix(value_key(value));
+    size_t index = hash >> (64 - counter.precision);
+
+    // Position of the first one bit in the rest of the hash, a sentinel bit caps it
+    uint64_t rest = (hash << counter.precision) | (uint64_t(1) << (counter.precision - 1));
+    uint8_t rank = static_cast<uint8_t>(__builtin_clzll(rest) + 1);
+    if (rank > counter.registers[index])
+        counter.registers[index] = rank;
+}
+
+double distinct_estimate(const distinct_counter &counter)
+{
+    double m = static_cast<double>(counter.registers.size());
+    if (m == 0)
+        return 0;
+
+    double inverse_sum = 0;
+    size_t zeros = 0;
+    for (uint8_t rank : counter.registers)
+    {
+        inverse_sum += std::ldexp(1.0, -rank);
+        zeros += rank == 0;
+    }
+
+    double alpha = 0.7213 / (1 + 1.079 / m);
+    double estimate = alpha * m * m / inverse_sum;
+
+    // Small counts: linear counting on the empty registers is more accurate
+    if (estimate <= 2.5 * m && zeros > 0)
+        estimate = m * std::log(m / zeros);
+    return estimate;
+}
+
+void distinct_merge(distinct_counter &counter, const distinct_counter &other)
+{
+    if (counter.registers.empty())
+    {
+        counter = other;
+        return;
+    }
+    for (size_t i = 0; i < counter.registers.size() && i < other.registers.size(); i++)
+    {
+        counter.registers[i] = std::max(counter.registers[i], other.registers[i]);
+    }
+}
+
+void init_count_min(count_min_sketch &sketch, double error, double confidence)
+{
+    // Rounding the width up to a power of two only tightens the bound. The error is
+    // floored like init_top_values', below that the rows would not fit in memory.
+    size_t width = static_cast<size_t>(std::ceil(std::exp(1.0) / std::max(error, 1e-6)));
+    sketch.width = 1;
+    while (sketch.width < width)
+    {
+        sketch.width *= 2;
+    }
+    sketch.depth = static_cast<size_t>(std::ceil(std::log(1 / std::max(1 - confidence, 1e-12))));
+    sketch.depth = std::max<size_t>(sketch.depth, 1);
+    sketch.total = 0;
+    sketch.counters.assign(sketch.width * sketch.depth, 0);
+}
+
+void count_min_add(count_min_sketch &sketch, double value)
+{
+    uint64_t hash = mix(value_key(value));
+    for (size_t row = 0; row < sketch.depth; row++)
+    {
+        sketch.counters[row * sketch.width + count_min_column(sketch, hash, row)]++;
+    }
+    sketch.total++;
+}
+
+uint64_t count_min_estimate(const count_min_sketch &sketch, double value)
+{
+    uint64_t hash = mix(value_key(value));
+    uint64_t estimate = std::numeric_limits<uint64_t>::max();
+    for (size_t row = 0; row < sketch.depth; row++)
+    {
+        estimate = std::min(estimate, sketch.counters[row * sketch.width + count_min_column(sketch, hash, row)]);
+    }
+    return sketch.depth == 0 ? 0 : estimate;
+}
+
+void count_min_merge(count_min_sketch &sketch, const count_min_sketch &other)
+{
+    if (sketch.counters.empty())
+    {
+        sketch = other;
+        return;
+    }
+    for (size_t i = 0; i < sketch.counters.size() && i < other.counters.size(); i++)
+    {
+        sketch.counters[i] += other.counters[i];
+    }
+    sketch.total += other.total;
+}
+
+void init_top_values(top_values &top, double error)
+{
+    top = top_values();
+    top.capacity = static_cast<size_t>(std::ceil(1 / std::max(error, 1e-6)));
+    top.heap.reserve(top.capacity);
+    top.position.reserve(top.capacity);
+}
+
+void top_add(top_values &top, double value)
+{
+    top.total++;
+    count_key(top, value_key(value), 1, 0);
+}
+
+void top_merge(top_values &top, const top_values &other)
+{
+    if (top.capacity == 0)
+    {
+        top = other;
+        return;
+    }
+
+    // Counting other's entries in keeps the error bound at (total + other.total) / capacity
+    for (const frequent_value &entry : other.heap)
+    {
+        count_key(top, entry.key, entry.count, entry.error);
+    }
+    top.total += other.total;
+}
+
+vector<frequent_value> top_list(const top_values &top, size_t count)
+{
+    vector<frequent_value> list = top.heap;
+    std::sort(list.begin(), list.end(), [](const frequent_value &a, const frequent_value &b)
+              { return a.count > b.count; });
+    if (list.size() > count)
+        list.resize(count);
+    return list;
+}
+
+double key_value(uint64_t key)
+{
+    double value;
+    std::memcpy(&value, &key, sizeof(value));
+    return value;
+}
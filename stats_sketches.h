@@ -0,0 +1,188 @@
+#ifndef STATS_SKETCHES_H
+#define STATS_SKETCHES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+using std::vector;
+
+// Default error bounds: about 1% for distinct counts and 0.1% of the stream for frequencies
+const double DEFAULT_DISTINCT_ERROR = 0.01;
+const double DEFAULT_FREQUENCY_ERROR = 0.001;
+const double DEFAULT_FREQUENCY_CONFIDENCE = 0.99;
+
+/**
+ * A HyperLogLog distinct counter. Each value's hash picks a register and
+ * the register keeps the longest run of leading zeros seen in the rest of
+ * the hash; the registers' harmonic mean estimates the number of distinct
+ * values with a relative error of about 1.04 / sqrt(register count).
+ *
+ * @field precision log2 of the register count
+ * @field registers the registers
+ */
+struct distinct_counter
+{
+    int precision = 0;
+    vector<uint8_t> registers;
+};
+
+/**
+ * A Count-Min sketch. Each value adds one to a counter in every row; its
+ * count is estimated by the smallest of those counters, which is never
+ * too low and, with probability confidence, at most error * total too high.
+ *
+ * @field width    counters per row, a power of two
+ * @field depth    number of rows
+ * @field total    how many values were added
+ * @field counters depth rows of width counters, row after row
+ */
+struct count_min_sketch
+{
+    size_t width = 0;
+    size_t depth = 0;
+    uint64_t total = 0;
+    vector<uint64_t> counters;
+};
+
+/**
+ * One value tracked by a Space-Saving summary.
+ *
+ * @field key   the value's bits
+ * @field count how often the value was counted
+ * @field error how much of count may belong to values it replaced
+ */
+struct frequent_value
+{
+    uint64_t key;
+    uint64_t count;
+    uint64_t error;
+};
+
+/**
+ * A Space-Saving summary of the most frequent values. It tracks a fixed
+ * number of values; an untracked value replaces the least counted one and
+ * inherits its count. Any value seen more than total / capacity times is
+ * tracked, and each count is at most error too high.
+ *
+ * @field capacity how many values are tracked
+ * @field total    how many values were added
+ * @field heap     the tracked values, a min-heap on count
+ * @field position where each tracked value is in the heap
+ */
+struct top_values
+{
+    size_t capacity = 0;
+    uint64_t total = 0;
+    vector<frequent_value> heap;
+    std::unordered_map<uint64_t, size_t> position;
+};
+
+/**
+ * Set up a distinct counter.
+ *
+ * @param counter        the counter
+ * @param relative_error the standard error wanted, e.g. 0.01 for 1%
+ */
+void init_distinct_counter(distinct_counter &counter, double relative_error);
+
+/**
+ * Add a value to a distinct counter.
+ *
+ * @param counter the counter
+ * @param value   the value to add
+ */
+void distinct_add(distinct_counter &counter, double value);
+
+/**
+ * Estimate how many distinct values were added.
+ *
+ * @param counter the counter
+ * @returns the estimate
+ */
+double distinct_estimate(const distinct_counter &counter);
+
+/**
+ * Merge one distinct counter into another. Both must use the same error.
+ *
+ * @param counter the counter to merge into
+ * @param other   the counter to merge from
+ */
+void distinct_merge(distinct_counter &counter, const distinct_counter &other);
+
+/**
+ * Set up a Count-Min sketch.
+ *
+ * @param sketch     the sketch
+ * @param error      how far an estimate may be over, as a fraction of the total
+ * @param confidence probability an estimate is within the error
+ */
+void init_count_min(count_min_sketch &sketch, double error, double confidence);
+
+/**
+ * Count a value in a Count-Min sketch.
+ *
+ * @param sketch the sketch
+ * @param value  the value to count
+ */
+void count_min_add(count_min_sketch &sketch, double value);
+
+/**
+ * Estimate how often a value was counted.
+ *
+ * @param sketch the sketch
+ * @param value  the value
+ * @returns the estimate, never below the true count
+ */
+uint64_t count_min_estimate(const count_min_sketch &sketch, double value);
+
+/**
+ * Merge one Count-Min sketch into another. Both must use the same bounds.
+ *
+ * @param sketch the sketch to merge into
+ * @param other  the sketch to merge from
+ */
+void count_min_merge(count_min_sketch &sketch, const count_min_sketch &other);
+
+/**
+ * Set up a Space-Saving summary.
+ *
+ * @param top   the summary
+ * @param error counts are at most error * total too high
+ */
+void init_top_values(top_values &top, double error);
+
+/**
+ * Count a value in a Space-Saving summary.
+ *
+ * @param top   the summary
+ * @param value the value to count
+ */
+void top_add(top_values &top, double value);
+
+/**
+ * Merge one Space-Saving summary into another.
+ *
+ * @param top   the summary to merge into
+ * @param other the summary to merge from
+ */
+void top_merge(top_values &top, const top_values &other);
+
+/**
+ * The most frequent values, most counted first.
+ *
+ * @param top   the summary
+ * @param count how many to return at most
+ * @returns the values, with their counts and errors
+ */
+vector<frequent_value> top_list(const top_values &top, size_t count);
+
+/**
+ * The value a frequent_value's key stands for.
+ *
+ * @param key the key
+ * @returns the value
+ */
+double key_value(uint64_t key);
+
+#endif
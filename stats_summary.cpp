@@ -0,0 +1,383 @@
+#include "stats_summary.h"
+#include "splashkit.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <utility>
+
+namespace
+{
+    const char SUMMARY_MAGIC[4] = {'S', 'T', 'S', 'M'};
+    const uint32_t SUMMARY_VERSION = 1;
+    const uint32_t MAX_SKETCH_LEVELS = 64;
+    const uint32_t MAX_SKETCH_K = 1 << 16; // Far more accurate than needed, and still fits in an int
+
+    // Fields are stored in the machine's byte order, like the other binary files here
+    template <typename T>
+    void put(vector<uint8_t> &out, const T &value)
+    {
+        const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&value);
+        out.insert(out.end(), bytes, bytes + sizeof(T));
+    }
+
+    template <typename T>
+    bool take(const uint8_t *&cursor, const uint8_t *end, T &value)
+    {
+        if (static_cast<size_t>(end - cursor) < sizeof(T))
+            return false;
+        std::memcpy(&value, cursor, sizeof(T));
+        cursor += sizeof(T);
+        return true;
+    }
+
+    // Levels shrink by 2/3 going down from the top one. Level 0 is kept at full
+    // size as a buffer, so each compaction there clears about k / 2 values.
+    const double LEVEL_SHRINK = 2.0 / 3.0;
+    const size_t MIN_LEVEL_CAPACITY = 8;
+
+    size_t level_capacity(const quantile_sketch &sketch, size_t level)
+    {
+        if (level == 0)
+            return sketch.k;
+
+        size_t depth = sketch.levels.size() - 1 - level;
+        size_t capacity = static_cast<size_t>(std::ceil(sketch.k * std::pow(LEVEL_SHRINK, static_cast<double>(depth))));
+        return std::max(capacity, MIN_LEVEL_CAPACITY);
+    }
+
+    void add_level(quantile_sketch &sketch)
+    {
+        sketch.levels.emplace_back();
+        sketch.capacity = 0;
+        for (size_t level = 0; level < sketch.levels.size(); level++)
+        {
+            sketch.capacity += level_capacity(sketch, level);
+        }
+    }
+
+    // Kahan-Babuska: add to a sum, keeping the bits of the smaller operand the addition drops
+    void compensated_add(double &sum, double &compensation, double value)
+    {
+        double result = sum + value;
+        if (std::fabs(sum) >= std::fabs(value))
+            compensation += (sum - result) + value;
+        else
+            compensation += (value - result) + sum;
+        sum = result;
+    }
+
+    // xorshift64, only needs to be unbiased about which half is promoted
+    bool random_bit(quantile_sketch &sketch)
+    {
+        sketch.random_state ^= sketch.random_state << 13;
+        sketch.random_state ^= sketch.random_state >> 7;
+        sketch.random_state ^= sketch.random_state << 17;
+        return sketch.random_state & 1;
+    }
+
+    // Halve the lowest full level, promoting every other item one level up
+    void compact(quantile_sketch &sketch)
+    {
+        for (size_t level = 0; level < sketch.levels.size(); level++)
+        {
+            if (sketch.levels[level].size() < level_capacity(sketch, level))
+                continue;
+
+            if (level + 1 == sketch.levels.size())
+            {
+                add_level(sketch);
+            }
+
+            vector<double> &items = sketch.levels[level];
+            vector<double> &above = sketch.levels[level + 1];
+            std::sort(items.begin(), items.end());
+
+            // With an odd count the largest item stays behind
+            size_t paired = items.size() & ~size_t(1);
+            for (size_t i = random_bit(sketch) ? 1 : 0; i < paired; i += 2)
+            {
+                above.push_back(items[i]);
+            }
+            sketch.retained -= paired / 2;
+            if (paired < items.size())
+            {
+                items[0] = items.back();
+                items.resize(1);
+            }
+            else
+            {
+                items.clear();
+            }
+            return;
+        }
+    }
+}
+
+void sketch_add(quantile_sketch &sketch, double value)
+{
+    if (sketch.levels.empty())
+    {
+        add_level(sketch);
+    }
+
+    // Compaction is lazy: only once the whole sketch is full, which amortises the sorting
+    sketch.levels[0].push_back(value);
+    sketch.retained++;
+    while (sketch.retained >= sketch.capacity)
+    {
+        compact(sketch);
+    }
+}
+
+double sketch_quantile(const quantile_sketch &sketch, double fraction)
+{
+    // Every item stands for 2^level values
+    vector<std::pair<double, uint64_t>> items;
+    uint64_t total_weight = 0;
+    for (size_t level = 0; level < sketch.levels.size(); level++)
+    {
+        for (double value : sketch.levels[level])
+        {
+            items.push_back({value, uint64_t(1) << level});
+            total_weight += uint64_t(1) << level;
+        }
+    }
+    if (items.empty())
+        return std::nan("");
+
+    std::sort(items.begin(), items.end());
+    double target = std::min(std::max(fraction, 0.0), 1.0) * total_weight;
+    uint64_t seen = 0;
+    for (const std::pair<double, uint64_t> &item : items)
+    {
+        seen += item.second;
+        if (seen >= target)
+            return item.first;
+    }
+    return items.back().first;
+}
+
+size_t sketch_size(const quantile_sketch &sketch)
+{
+    return sketch.retained;
+}
+
+bool sketch_merge(quantile_sketch &sketch, const quantile_sketch &other)
+{
+    if (sketch.k != other.k)
+        return false;
+
+    while (sketch.levels.size() < std::max<size_t>(other.levels.size(), 1))
+    {
+        add_level(sketch);
+    }
+
+    // Items keep their level, so they keep their weight
+    for (size_t level = 0; level < other.levels.size(); level++)
+    {
+        sketch.levels[level].insert(sketch.levels[level].end(), other.levels[level].begin(), other.levels[level].end());
+    }
+    sketch.retained += other.retained;
+    sketch.random_state ^= other.random_state;
+    if (sketch.random_state == 0)
+    {
+        sketch.random_state = 0x9E3779B97F4A7C15ull;
+    }
+
+    while (sketch.retained >= sketch.capacity)
+    {
+        compact(sketch);
+    }
+    return true;
+}
+
+void add_value(stats_summary &summary, double value)
+{
+    summary.count++;
+
+    compensated_add(summary.sum, summary.sum_compensation, value);
+
+    summary.min = std::min(summary.min, value);
+    summary.max = std::max(summary.max, value);
+
+    // Welford's update, stable where sum of squares minus square of sum is not
+    double delta = value - summary.mean;
+    summary.mean += delta / summary.count;
+    summary.m2 += delta * (value - summary.mean);
+
+    sketch_add(summary.sketch, value);
+}
+
+bool merge_summary(stats_summary &summary, const stats_summary &other)
+{
+    if (summary.sketch.k != other.sketch.k)
+        return false;
+    if (other.count == 0)
+        return true;
+
+    // Chan et al.'s pairwise update combines the two sets of moments
+    uint64_t count = summary.count + other.count;
+    double delta = other.mean - summary.mean;
+    summary.mean += delta * other.count / count;
+    summary.m2 += other.m2 + delta * delta * (static_cast<double>(summary.count) * other.count / count);
+    summary.count = count;
+
+    compensated_add(summary.sum, summary.sum_compensation, other.sum);
+    summary.sum_compensation += other.sum_compensation;
+
+    summary.min = std::min(summary.min, other.min);
+    summary.max = std::max(summary.max, other.max);
+
+    sketch_merge(summary.sketch, other.sketch);
+    return true;
+}
+
+bool reduce_summaries(vector<stats_summary> &summaries)
+{
+    // Checked up front so a mismatch doesn't leave the list half merged
+    for (const stats_summary &summary : summaries)
+    {
+        if (summary.sketch.k != summaries[0].sketch.k)
+            return false;
+    }
+
+    for (size_t step = 1; step < summaries.size(); step *= 2)
+    {
+        for (size_t i = 0; i + step < summaries.size(); i += 2 * step)
+        {
+            merge_summary(summaries[i], summaries[i + step]);
+        }
+    }
+    return true;
+}
+
+void write_summary(const stats_summary &summary, vector<uint8_t> &out)
+{
+    out.insert(out.end(), SUMMARY_MAGIC, SUMMARY_MAGIC + sizeof(SUMMARY_MAGIC));
+    put(out, SUMMARY_VERSION);
+    put(out, summary.count);
+    put(out, summary.sum);
+    put(out, summary.sum_compensation);
+    put(out, summary.min);
+    put(out, summary.max);
+    put(out, summary.mean);
+    put(out, summary.m2);
+
+    const quantile_sketch &sketch = summary.sketch;
+    put(out, static_cast<uint32_t>(sketch.k));
+    put(out, sketch.random_state);
+    put(out, static_cast<uint32_t>(sketch.levels.size()));
+    for (const vector<double> &level : sketch.levels)
+    {
+        put(out, static_cast<uint32_t>(level.size()));
+        const uint8_t *bytes = reinterpret_cast<const uint8_t *>(level.data());
+        out.insert(out.end(), bytes, bytes + level.size() * sizeof(double));
+    }
+}
+
+bool read_summary(const uint8_t *data, size_t size, stats_summary &summary)
+{
+    const uint8_t *cursor = data;
+    const uint8_t *end = data + size;
+    if (size < sizeof(SUMMARY_MAGIC) || std::memcmp(data, SUMMARY_MAGIC, sizeof(SUMMARY_MAGIC)) != 0)
+        return false;
+    cursor += sizeof(SUMMARY_MAGIC);
+
+    stats_summary result;
+    uint32_t version = 0;
+    uint32_t k = 0;
+    uint32_t level_count = 0;
+    bool ok = take(cursor, end, version) && version == SUMMARY_VERSION &&
+              take(cursor, end, result.count) &&
+              take(cursor, end, result.sum) &&
+              take(cursor, end, result.sum_compensation) &&
+              take(cursor, end, result.min) &&
+              take(cursor, end, result.max) &&
+              take(cursor, end, result.mean) &&
+              take(cursor, end, result.m2) &&
+              take(cursor, end, k) && k >= 2 && k <= MAX_SKETCH_K &&
+              take(cursor, end, result.sketch.random_state) &&
+              take(cursor, end, level_count) && level_count <= MAX_SKETCH_LEVELS;
+    if (!ok)
+        return false;
+
+    quantile_sketch &sketch = result.sketch;
+    sketch.k = static_cast<int>(k);
+    for (uint32_t level = 0; level < level_count; level++)
+    {
+        add_level(sketch);
+        uint32_t items = 0;
+        if (!take(cursor, end, items) || static_cast<size_t>(end - cursor) / sizeof(double) < items)
+            return false;
+        sketch.levels[level].resize(items);
+        std::memcpy(sketch.levels[level].data(), cursor, items * sizeof(double));
+        cursor += items * sizeof(double);
+        sketch.retained += items;
+    }
+
+    if (cursor != end)
+        return false;
+
+    summary = std::move(result);
+    return true;
+}
+
+bool save_summary(const stats_summary &summary, const string &path)
+{
+    vector<uint8_t> bytes;
+    write_summary(summary, bytes);
+
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char *>(bytes.data()), bytes.size());
+    return static_cast<bool>(file);
+}
+
+bool load_summary(stats_summary &summary, const string &path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file)
+        return false;
+
+    vector<uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    return read_summary(bytes.data(), bytes.size(), summary);
+}
+
+double summary_total(const stats_summary &summary)
+{
+    return summary.sum + summary.sum_compensation;
+}
+
+double summary_variance(const stats_summary &summary)
+{
+    return summary.count < 2 ? 0.0 : summary.m2 / (summary.count - 1);
+}
+
+double summary_stddev(const stats_summary &summary)
+{
+    return std::sqrt(summary_variance(summary));
+}
+
+double summary_quantile(const stats_summary &summary, double fraction)
+{
+    return sketch_quantile(summary.sketch, fraction);
+}
+
+void print_summary(const stats_summary &summary)
+{
+    write_line("Count: " + std::to_string(summary.count));
+    if (summary.count == 0)
+        return;
+
+    write_line("Total: " + std::to_string(summary_total(summary)));
+    write_line("Min: " + std::to_string(summary.min));
+    write_line("Max: " + std::to_string(summary.max));
+    write_line("Average: " + std::to_string(summary.mean));
+    write_line("Variance: " + std::to_string(summary_variance(summary)));
+    write_line("Std dev: " + std::to_string(summary_stddev(summary)));
+    write_line("p50: " + std::to_string(summary_quantile(summary, 0.5)) +
+               ", p90: " + std::to_string(summary_quantile(summary, 0.9)) +
+               ", p99: " + std::to_string(summary_quantile(summary, 0.99)));
+}
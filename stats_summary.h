@@ -0,0 +1,198 @@
+#ifndef STATS_SUMMARY_H
+#define STATS_SUMMARY_H
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <vector>
+using std::string;
+using std::vector;
+
+// Accuracy of the quantile sketch: rank error is roughly 1.7 / k, so 200 gives about 1%
+const int DEFAULT_SKETCH_K = 200;
+
+/**
+ * A KLL quantile sketch. Values are kept in levels; an item at level h
+ * stands for 2^h of the values seen. When the sketch is full a level is
+ * sorted and every other item is promoted to the next level, so memory
+ * stays bounded (a few thousand doubles) however many values are added.
+ *
+ * @field k            accuracy parameter, the capacity of the top level
+ * @field levels       the retained items, levels[0] holds raw values
+ * @field retained     items held across all levels
+ * @field capacity     items the levels can hold before one is compacted
+ * @field random_state state of the generator picking which half to promote
+ */
+struct quantile_sketch
+{
+    int k = DEFAULT_SKETCH_K;
+    vector<vector<double>> levels;
+    size_t retained = 0;
+    size_t capacity = 0;
+    uint64_t random_state = 0x9E3779B97F4A7C15ull;
+};
+
+/**
+ * Streaming statistics over a sequence of values, in constant memory.
+ *
+ * @field count            how many values were added
+ * @field sum              running total
+ * @field sum_compensation low order bits lost from sum (Kahan-Babuska summation)
+ * @field min              smallest value
+ * @field max              largest value
+ * @field mean             running mean (Welford)
+ * @field m2               sum of squared differences from the mean (Welford)
+ * @field sketch           quantile sketch of the values
+ */
+struct stats_summary
+{
+    uint64_t count = 0;
+    double sum = 0;
+    double sum_compensation = 0;
+    double min = std::numeric_limits<double>::infinity();
+    double max = -std::numeric_limits<double>::infinity();
+    double mean = 0;
+    double m2 = 0;
+    quantile_sketch sketch;
+};
+
+/**
+ * Add a value to a quantile sketch.
+ *
+ * @param sketch the sketch
+ * @param value  the value to add
+ */
+void sketch_add(quantile_sketch &sketch, double value);
+
+/**
+ * Estimate a quantile from a sketch.
+ *
+ * @param sketch   the sketch
+ * @param fraction the quantile, e.g. 0.5 for the median
+ * @returns the estimate, or NaN if the sketch is empty
+ */
+double sketch_quantile(const quantile_sketch &sketch, double fraction);
+
+/**
+ * Count the items a sketch is holding.
+ *
+ * @param sketch the sketch
+ * @returns the number of retained items
+ */
+size_t sketch_size(const quantile_sketch &sketch);
+
+/**
+ * Merge one quantile sketch into another. Both must use the same k, as
+ * items compacted at a different k would carry the wrong weight.
+ *
+ * @param sketch the sketch to merge into
+ * @param other  the sketch to merge from
+ * @returns false, leaving sketch alone, if the two use different k
+ */
+bool sketch_merge(quantile_sketch &sketch, const quantile_sketch &other);
+
+/**
+ * Add a value to a summary.
+ *
+ * @param summary the summary
+ * @param value   the value to add
+ */
+void add_value(stats_summary &summary, double value);
+
+/**
+ * Merge one summary into another, as if every value added to other had
+ * been added to summary.
+ *
+ * @param summary the summary to merge into
+ * @param other   the summary to merge from
+ * @returns false, leaving summary alone, if their sketches use different k
+ */
+bool merge_summary(stats_summary &summary, const stats_summary &other);
+
+/**
+ * Merge a list of summaries pairwise, as a tree, into the first one.
+ * Merging is associative, so the result does not depend on how the
+ * values were split between the summaries.
+ *
+ * @param summaries the summaries, summaries[0] receives the result
+ * @returns false, merging nothing, if their sketches don't all use the same k
+ */
+bool reduce_summaries(vector<stats_summary> &summaries);
+
+/**
+ * Encode a summary as compact binary, including its sketch.
+ *
+ * @param summary the summary
+ * @param out     the bytes are appended here
+ */
+void write_summary(const stats_summary &summary, vector<uint8_t> &out);
+
+/**
+ * Decode a summary written by write_summary.
+ *
+ * @param data    the encoded bytes
+ * @param size    how many bytes there are
+ * @param summary receives the summary
+ * @returns false if the data is not a valid summary
+ */
+bool read_summary(const uint8_t *data, size_t size, stats_summary &summary);
+
+/**
+ * Save a summary to a file.
+ *
+ * @param summary the summary
+ * @param path    the file to write
+ * @returns true if the file was written
+ */
+bool save_summary(const stats_summary &summary, const string &path);
+
+/**
+ * Load a summary saved with save_summary.
+ *
+ * @param summary receives the summary
+ * @param path    the file to read
+ * @returns true if the file held a valid summary
+ */
+bool load_summary(stats_summary &summary, const string &path);
+
+/**
+ * The compensated total of the values.
+ *
+ * @param summary the summary
+ * @returns the total
+ */
+double summary_total(const stats_summary &summary);
+
+/**
+ * The sample variance of the values.
+ *
+ * @param summary the summary
+ * @returns the variance, 0 for fewer than two values
+ */
+double summary_variance(const stats_summary &summary);
+
+/**
+ * The sample standard deviation of the values.
+ *
+ * @param summary the summary
+ * @returns the standard deviation
+ */
+double summary_stddev(const stats_summary &summary);
+
+/**
+ * Estimate a quantile of the values.
+ *
+ * @param summary  the summary
+ * @param fraction the quantile, e.g. 0.99 for p99
+ * @returns the estimate
+ */
+double summary_quantile(const stats_summary &summary, double fraction);
+
+/**
+ * Print every statistic in a summary.
+ *
+ * @param summary the summary
+ */
+void print_summary(const stats_summary &summary);
+
+#endif
@@ -0,0 +1,223 @@
+#include "stats_window.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    // Drop values the new one beats: they can never be the best again
+    void push_candidate(monotonic_deque &deque, double position, double value)
+    {
+        while (!deque.entries.empty() &&
+               (deque.keep_smaller ? deque.entries.back().second >= value : deque.entries.back().second <= value))
+        {
+            deque.entries.pop_back();
+        }
+        deque.entries.push_back({position, value});
+    }
+
+    // Drop candidates from before the window's oldest position
+    void expire_candidates(monotonic_deque &deque, double oldest)
+    {
+        while (!deque.entries.empty() && deque.entries.front().first < oldest)
+        {
+            deque.entries.pop_front();
+        }
+    }
+
+    int64_t bucket_number(const time_window &window, double time)
+    {
+        return static_cast<int64_t>(std::floor(time / window.bucket_seconds));
+    }
+
+    // Clear any slots whose bucket has slid out, up to and including bucket
+    void advance_buckets(time_window &window, int64_t bucket)
+    {
+        if (bucket <= window.latest)
+            return;
+
+        int64_t slots = static_cast<int64_t>(window.buckets.size());
+        int64_t first = window.latest == std::numeric_limits<int64_t>::min() ? bucket - slots + 1
+                                                                             : std::max(window.latest + 1, bucket - slots + 1);
+        for (int64_t number = first; number <= bucket; number++)
+        {
+            size_t slot = static_cast<size_t>(((number % slots) + slots) % slots);
+            window.buckets[slot] = window_moments();
+            window.bucket_index[slot] = number;
+        }
+        window.latest = bucket;
+    }
+}
+
+void add_moment(window_moments &moments, double value)
+{
+    moments.count++;
+    double delta = value - moments.mean;
+    moments.mean += delta / moments.count;
+    moments.m2 += delta * (value - moments.mean);
+    moments.min = std::min(moments.min, value);
+    moments.max = std::max(moments.max, value);
+}
+
+void merge_moments(window_moments &moments, const window_moments &other)
+{
+    if (other.count == 0)
+        return;
+
+    // Chan et al.'s pairwise update, as in merge_summary
+    uint64_t count = moments.count + other.count;
+    double delta = other.mean - moments.mean;
+    moments.mean += delta * other.count / count;
+    moments.m2 += other.m2 + delta * delta * (static_cast<double>(moments.count) * other.count / count);
+    moments.count = count;
+    moments.min = std::min(moments.min, other.min);
+    moments.max = std::max(moments.max, other.max);
+}
+
+double moments_variance(const window_moments &moments)
+{
+    return moments.count < 2 ? 0.0 : moments.m2 / (moments.count - 1);
+}
+
+void init_count_window(count_window &window, size_t capacity)
+{
+    window = count_window();
+    window.capacity = std::max<size_t>(capacity, 1);
+    window.values.reserve(window.capacity);
+    window.minimum.keep_smaller = true;
+    window.maximum.keep_smaller = false;
+}
+
+void add_to_window(count_window &window, double value)
+{
+    if (window.added == 0)
+    {
+        window.shift = value;
+    }
+
+    // Position of the value, and the oldest position still in the window
+    double position = static_cast<double>(window.added);
+    window.added++;
+    double oldest = static_cast<double>(window.added > window.capacity ? window.added - window.capacity : 0);
+
+    double shifted = value - window.shift;
+    if (window.values.size() < window.capacity)
+    {
+        window.values.push_back(value);
+    }
+    else
+    {
+        double dropped = window.values[window.next] - window.shift;
+        window.sum -= dropped;
+        window.sum_squares -= dropped * dropped;
+        window.values[window.next] = value;
+    }
+    window.sum += shifted;
+    window.sum_squares += shifted * shifted;
+    window.next = (window.next + 1) % window.capacity;
+
+    // Once per lap of the ring, re-centre on the window and rebuild the sums
+    if (window.next == 0)
+    {
+        window.shift = window.sum / window.values.size() + window.shift;
+        window.sum = 0;
+        window.sum_squares = 0;
+        for (double stored : window.values)
+        {
+            window.sum += stored - window.shift;
+            window.sum_squares += (stored - window.shift) * (stored - window.shift);
+        }
+    }
+
+    push_candidate(window.minimum, position, value);
+    push_candidate(window.maximum, position, value);
+    expire_candidates(window.minimum, oldest);
+    expire_candidates(window.maximum, oldest);
+}
+
+window_moments window_stats(const count_window &window)
+{
+    window_moments moments;
+    moments.count = window.values.size();
+    if (moments.count == 0)
+        return moments;
+
+    double n = static_cast<double>(moments.count);
+    double offset = window.sum / n;
+    moments.mean = window.shift + offset;
+    moments.m2 = std::max(0.0, window.sum_squares - n * offset * offset);
+    moments.min = window.minimum.entries.front().second;
+    moments.max = window.maximum.entries.front().second;
+    return moments;
+}
+
+void init_time_window(time_window &window, double seconds, int buckets)
+{
+    window = time_window();
+    buckets = std::max(buckets, 1);
+    window.seconds = seconds;
+    window.bucket_seconds = seconds / buckets;
+    window.buckets.resize(buckets);
+    window.bucket_index.assign(buckets, std::numeric_limits<int64_t>::min());
+    window.minimum.keep_smaller = true;
+    window.maximum.keep_smaller = false;
+}
+
+void add_to_window(time_window &window, double time, double value)
+{
+    int64_t bucket = bucket_number(window, time);
+    advance_buckets(window, bucket);
+
+    int64_t slots = static_cast<int64_t>(window.buckets.size());
+    add_moment(window.buckets[static_cast<size_t>(((bucket % slots) + slots) % slots)], value);
+
+    push_candidate(window.minimum, time, value);
+    push_candidate(window.maximum, time, value);
+    expire_candidates(window.minimum, time - window.seconds);
+    expire_candidates(window.maximum, time - window.seconds);
+}
+
+window_moments window_stats(time_window &window, double time)
+{
+    advance_buckets(window, bucket_number(window, time));
+    expire_candidates(window.minimum, time - window.seconds);
+    expire_candidates(window.maximum, time - window.seconds);
+
+    window_moments moments;
+    for (size_t slot = 0; slot < window.buckets.size(); slot++)
+    {
+        if (window.bucket_index[slot] != std::numeric_limits<int64_t>::min())
+        {
+            merge_moments(moments, window.buckets[slot]);
+        }
+    }
+
+    // Min and max are exact to the second, not to the bucket
+    if (!window.minimum.entries.empty())
+    {
+        moments.min = window.minimum.entries.front().second;
+        moments.max = window.maximum.entries.front().second;
+    }
+    return moments;
+}
+
+bool add_to_window(tumbling_window &window, double time, double value)
+{
+    int64_t period = static_cast<int64_t>(std::floor(time / window.seconds));
+    bool started = window.period != std::numeric_limits<int64_t>::min() && period != window.period;
+    if (period != window.period)
+    {
+        // After a gap of a whole period or more, the period just before this one was empty
+        window.finished = period == window.period + 1 ? window.current : window_moments();
+        window.current = window_moments();
+        window.period = period;
+    }
+    add_moment(window.current, value);
+    return started;
+}
+
+window_moments window_stats(const tumbling_window &window, double time)
+{
+    int64_t period = static_cast<int64_t>(std::floor(time / window.seconds));
+    return period == window.period ? window.current : window_moments();
+}
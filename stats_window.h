@@ -0,0 +1,210 @@
+#ifndef STATS_WINDOW_H
+#define STATS_WINDOW_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <utility>
+#include <vector>
+using std::vector;
+
+/**
+ * Count, mean, variance (Welford) and range of a group of values.
+ *
+ * @field count how many values
+ * @field mean  their mean
+ * @field m2    sum of squared differences from the mean
+ * @field min   smallest value
+ * @field max   largest value
+ */
+struct window_moments
+{
+    uint64_t count = 0;
+    double mean = 0;
+    double m2 = 0;
+    double min = std::numeric_limits<double>::infinity();
+    double max = -std::numeric_limits<double>::infinity();
+};
+
+/**
+ * A monotonic deque: the candidates for the minimum (or maximum) of a
+ * sliding window, each with the position it expires at. Every value is
+ * pushed and popped at most once, so updates are O(1) amortized.
+ *
+ * @field keep_smaller true to track the minimum, false for the maximum
+ * @field entries      (position, value) pairs, best value at the front
+ */
+struct monotonic_deque
+{
+    bool keep_smaller = true;
+    std::deque<std::pair<double, double>> entries;
+};
+
+/**
+ * Statistics of the last N values. Mean and variance come from running
+ * sums shifted by a reference value, rebuilt from the stored values every
+ * N updates so rounding errors cannot build up.
+ *
+ * @field capacity    N, the number of values covered
+ * @field values      ring of the last N values
+ * @field next        where the next value goes in the ring
+ * @field added       how many values have ever been added
+ * @field shift       reference value subtracted before summing
+ * @field sum         sum of (value - shift) over the window
+ * @field sum_squares sum of (value - shift)^2 over the window
+ * @field minimum     candidates for the window minimum
+ * @field maximum     candidates for the window maximum
+ */
+struct count_window
+{
+    size_t capacity = 0;
+    vector<double> values;
+    size_t next = 0;
+    uint64_t added = 0;
+    double shift = 0;
+    double sum = 0;
+    double sum_squares = 0;
+    monotonic_deque minimum;
+    monotonic_deque maximum;
+};
+
+/**
+ * Statistics of the values from the last T seconds. The span is split
+ * into a ring of buckets, each with its own moments; a bucket is cleared
+ * when its slot comes round again. Min and max are exact, from monotonic
+ * deques; mean and variance cover whole buckets, so the window's oldest
+ * edge moves in steps of T / bucket count.
+ *
+ * @field seconds        T, the span covered
+ * @field bucket_seconds span of each bucket
+ * @field buckets        the ring of buckets
+ * @field bucket_index   absolute bucket number held in each slot
+ * @field latest         absolute bucket number of the newest value
+ * @field minimum        candidates for the window minimum
+ * @field maximum        candidates for the window maximum
+ */
+struct time_window
+{
+    double seconds = 0;
+    double bucket_seconds = 0;
+    vector<window_moments> buckets;
+    vector<int64_t> bucket_index;
+    int64_t latest = std::numeric_limits<int64_t>::min();
+    monotonic_deque minimum;
+    monotonic_deque maximum;
+};
+
+/**
+ * Statistics in back to back, non overlapping periods (e.g. per minute).
+ *
+ * @field seconds  length of each period
+ * @field period   number of the period being filled
+ * @field current  moments of the period being filled
+ * @field finished moments of the period before the one being filled
+ */
+struct tumbling_window
+{
+    double seconds = 60;
+    int64_t period = std::numeric_limits<int64_t>::min();
+    window_moments current;
+    window_moments finished;
+};
+
+/**
+ * Add a value to a set of moments.
+ *
+ * @param moments the moments
+ * @param value   the value to add
+ */
+void add_moment(window_moments &moments, double value);
+
+/**
+ * Merge one set of moments into another.
+ *
+ * @param moments the moments to merge into
+ * @param other   the moments to merge from
+ */
+void merge_moments(window_moments &moments, const window_moments &other);
+
+/**
+ * The sample variance of a set of moments.
+ *
+ * @param moments the moments
+ * @returns the variance, 0 for fewer than two values
+ */
+double moments_variance(const window_moments &moments);
+
+/**
+ * Set up a window over the last N values.
+ *
+ * @param window   the window
+ * @param capacity N, at least 1
+ */
+void init_count_window(count_window &window, size_t capacity);
+
+/**
+ * Add a value to a count window, dropping the oldest once it is full.
+ *
+ * @param window the window
+ * @param value  the value to add
+ */
+void add_to_window(count_window &window, double value);
+
+/**
+ * The statistics of the values in a count window.
+ *
+ * @param window the window
+ * @returns their moments
+ */
+window_moments window_stats(const count_window &window);
+
+/**
+ * Set up a window over the last T seconds.
+ *
+ * @param window  the window
+ * @param seconds T
+ * @param buckets how many buckets to split T into
+ */
+void init_time_window(time_window &window, double seconds, int buckets);
+
+/**
+ * Add a value to a time window. Times must not go backwards.
+ *
+ * @param window the window
+ * @param time   when the value arrived, in seconds
+ * @param value  the value to add
+ */
+void add_to_window(time_window &window, double time, double value);
+
+/**
+ * The statistics of the values in a time window, as of a given time.
+ *
+ * @param window the window
+ * @param time   the current time, in seconds
+ * @returns their moments
+ */
+window_moments window_stats(time_window &window, double time);
+
+/**
+ * Add a value to a tumbling window. Times must not go backwards.
+ *
+ * @param window the window
+ * @param time   when the value arrived, in seconds
+ * @param value  the value to add
+ * @returns true if this value started a new period; the period before is
+ *          then in window.finished, empty if no values arrived in it
+ */
+bool add_to_window(tumbling_window &window, double time, double value);
+
+/**
+ * The statistics of the period a given time falls in. Values only arrive
+ * through add_to_window, so the stored period may have ended since.
+ *
+ * @param window the window
+ * @param time   the current time, in seconds
+ * @returns the moments of that period, empty if nothing was added in it
+ */
+window_moments window_stats(const tumbling_window &window, double time);
+
+#endif
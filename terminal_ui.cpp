@@ -0,0 +1,191 @@
+#include "terminal_ui.h"
+#include "output_buffer.h"
+
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+namespace
+{
+    // Never matches a drawn cell, so the first frame sends everything
+    const screen_cell UNKNOWN_CELL = {'\0', 0xFF};
+    const screen_cell BLANK_CELL = {' ', STYLE_NORMAL};
+
+    // Gaps up to this long are cheaper to rewrite than to jump over
+    const int MAX_REWRITE_GAP = 4;
+
+    int terminal_rows()
+    {
+        winsize size;
+        if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &size) == 0 && size.ws_row > 0)
+            return size.ws_row;
+        return 24;
+    }
+
+    bool same_cell(const screen_cell &a, const screen_cell &b)
+    {
+        return a.ch == b.ch && a.style == b.style;
+    }
+
+    void write_all(const string &text)
+    {
+        size_t written = 0;
+        while (written < text.size())
+        {
+            ssize_t result = ::write(STDOUT_FILENO, text.data() + written, text.size() - written);
+            if (result <= 0)
+                return;
+            written += static_cast<size_t>(result);
+        }
+    }
+
+    void append_number(string &out, int number)
+    {
+        out += std::to_string(number);
+    }
+
+    void move_cursor(string &out, int x, int y)
+    {
+        out += "\x1b[";
+        append_number(out, y + 1);
+        out += ';';
+        append_number(out, x + 1);
+        out += 'H';
+    }
+
+    void set_style(string &out, uint8_t style)
+    {
+        out += "\x1b[0";
+        if (style & STYLE_BOLD)
+            out += ";1";
+        if (style & STYLE_INVERSE)
+            out += ";7";
+        out += 'm';
+    }
+}
+
+void open_terminal_screen(terminal_screen &screen, int width, int height)
+{
+    screen.width = width;
+    screen.height = height;
+    screen.front.assign(static_cast<size_t>(width) * height, UNKNOWN_CELL);
+    screen.back.assign(static_cast<size_t>(width) * height, BLANK_CELL);
+    screen.active = true;
+
+    // Clear, then let only the rows below the panel scroll
+    flush_output(console_output());
+    string setup = "\x1b[2J\x1b[";
+    append_number(setup, height + 1);
+    setup += ';';
+    append_number(setup, terminal_rows());
+    setup += 'r';
+    move_cursor(setup, 0, height);
+    write_all(setup);
+}
+
+void close_terminal_screen(terminal_screen &screen)
+{
+    if (!screen.active)
+        return;
+
+    flush_output(console_output());
+    string reset = "\x1b[0m\x1b[r";
+    move_cursor(reset, 0, terminal_rows() - 1);
+    reset += '\n';
+    write_all(reset);
+    screen.active = false;
+}
+
+void clear_screen_buffer(terminal_screen &screen)
+{
+    screen.back.assign(screen.back.size(), BLANK_CELL);
+}
+
+void put_text(terminal_screen &screen, int x, int y, const string &text, uint8_t style)
+{
+    if (y < 0 || y >= screen.height)
+        return;
+
+    for (size_t i = 0; i < text.size(); i++)
+    {
+        int column = x + static_cast<int>(i);
+        if (column < 0)
+            continue;
+        if (column >= screen.width)
+            break;
+        screen.back[y * screen.width + column] = {text[i], style};
+    }
+}
+
+void fill_row(terminal_screen &screen, int y, uint8_t style)
+{
+    if (y < 0 || y >= screen.height)
+        return;
+
+    for (int x = 0; x < screen.width; x++)
+    {
+        screen.back[y * screen.width + x].style = style;
+    }
+}
+
+size_t present_screen(terminal_screen &screen)
+{
+    if (!screen.active)
+        return 0;
+
+    // Save the cursor, draw the changed cells, then put it back for the next prompt
+    string &out = screen.frame;
+    out.assign("\x1b" "7");
+    size_t empty_frame = out.size();
+
+    int cursor_x = -1;
+    int cursor_y = -1;
+    int style = -1;
+    for (int y = 0; y < screen.height; y++)
+    {
+        for (int x = 0; x < screen.width; x++)
+        {
+            const screen_cell &cell = screen.back[y * screen.width + x];
+            if (same_cell(cell, screen.front[y * screen.width + x]))
+                continue;
+
+            // Short gaps on the same row are rewritten, longer ones jumped
+            if (y == cursor_y && x > cursor_x && x - cursor_x <= MAX_REWRITE_GAP)
+            {
+                for (int gap = cursor_x; gap < x; gap++)
+                {
+                    const screen_cell &unchanged = screen.back[y * screen.width + gap];
+                    if (unchanged.style != style)
+                    {
+                        set_style(out, unchanged.style);
+                        style = unchanged.style;
+                    }
+                    out += unchanged.ch;
+                }
+            }
+            else if (y != cursor_y || x != cursor_x)
+            {
+                move_cursor(out, x, y);
+            }
+
+            if (cell.style != style)
+            {
+                set_style(out, cell.style);
+                style = cell.style;
+            }
+            out += cell.ch;
+            cursor_x = x + 1;
+            cursor_y = y;
+        }
+    }
+
+    screen.front = screen.back;
+    if (out.size() == empty_frame)
+        return 0;
+
+    out += "\x1b[0m\x1b" "8";
+
+    // Anything still buffered belongs before the frame
+    flush_output(console_output());
+    write_all(out);
+    return out.size();
+}
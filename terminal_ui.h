@@ -0,0 +1,105 @@
+#ifndef TERMINAL_UI_H
+#define TERMINAL_UI_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+using std::string;
+using std::vector;
+
+// Styles for screen cells, combined with |
+const uint8_t STYLE_NORMAL = 0;
+const uint8_t STYLE_BOLD = 1;
+const uint8_t STYLE_INVERSE = 2;
+
+/**
+ * One character cell of the screen.
+ *
+ * @field ch    the character shown
+ * @field style STYLE_ flags it is shown with
+ */
+struct screen_cell
+{
+    char ch;
+    uint8_t style;
+};
+
+/**
+ * A panel fixed to the top rows of the terminal, redrawn by diffing. Text
+ * is drawn into the back buffer; presenting it compares it with the front
+ * buffer (what the terminal shows) and sends only the cells that changed,
+ * in one write. The rows below the panel are left to scroll as normal, so
+ * prompts and messages still work while the panel stays put.
+ *
+ * @field width  columns in the panel
+ * @field height rows in the panel
+ * @field front  what the terminal is showing
+ * @field back   what the next frame will show
+ * @field frame  the escape sequences of the frame being built
+ * @field active whether the panel has been set up on the terminal
+ */
+struct terminal_screen
+{
+    int width = 0;
+    int height = 0;
+    vector<screen_cell> front;
+    vector<screen_cell> back;
+    string frame;
+    bool active = false;
+};
+
+/**
+ * Reserve the top rows of the terminal for a panel. The terminal is
+ * cleared and the cursor put just below the panel.
+ *
+ * @param screen the panel
+ * @param width  columns in the panel
+ * @param height rows in the panel
+ */
+void open_terminal_screen(terminal_screen &screen, int width, int height);
+
+/**
+ * Give the whole terminal back to scrolling text.
+ *
+ * @param screen the panel
+ */
+void close_terminal_screen(terminal_screen &screen);
+
+/**
+ * Blank the back buffer, ready to draw the next frame.
+ *
+ * @param screen the panel
+ */
+void clear_screen_buffer(terminal_screen &screen);
+
+/**
+ * Draw text into the back buffer. Text running off the panel is cut off.
+ *
+ * @param screen the panel
+ * @param x      column of the first character
+ * @param y      row
+ * @param text   the text
+ * @param style  STYLE_ flags
+ */
+void put_text(terminal_screen &screen, int x, int y, const string &text, uint8_t style = STYLE_NORMAL);
+
+/**
+ * Fill a row of the back buffer with one style, e.g. for a title bar.
+ *
+ * @param screen the panel
+ * @param y      row
+ * @param style  STYLE_ flags
+ */
+void fill_row(terminal_screen &screen, int y, uint8_t style);
+
+/**
+ * Send the back buffer's changes to the terminal and make it the front.
+ * The cursor is left where it was, below the panel.
+ *
+ * @param screen the panel
+ * @returns how many bytes were written
+ */
+size_t present_screen(terminal_screen &screen);
+
+#endif
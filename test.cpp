@@ -3,24 +3,40 @@
 // Access read_integer and read_string in utilities
 #include "utilities.h"
 
+// Record or replay the input from the command line
+#include "input_script.h"
+
+// Names and lookups for enums, built from one list
+#include "enum_reflection.h"
+
 using std::to_string;
 
+/**
+ * The genres captured in the software, with the name of each. This list
+ * is the only place to add a genre: the enum, its names and the lookup
+ * table for reading names are all built from it.
+ */
+#define GENRE_LIST(X)                      \
+    X(FANTASY, "fantasy")                  \
+    X(SCIENCE_FICTION, "science fiction")  \
+    X(MYSTERY, "mystery")                  \
+    X(ROMANCE, "romance")                  \
+    X(COOKING, "cooking")                  \
+    X(NONFICTION, "nonfiction")
+
 /**
  * Genre data captures the list of genre's captured in the software.
  */
 enum genre_data
 {
-    FANTASY = 0,
-    SCIENCE_FICTION,
-    MYSTERY,
-    ROMANCE,
-    COOKING,
-    NONFICTION
+    GENRE_LIST(ENUM_VALUE)
 };
 
-// Get the number of genres. Cast the last
-// one to an integer and add one as it start from 0
-const int GENRE_COUNT = (int)NONFICTION + 1;
+// The names of the genres, worked out when the program is compiled
+constexpr auto GENRE_NAMES = make_enum_names<genre_data>({GENRE_LIST(ENUM_NAME)});
+
+// Get the number of genres from the list of names
+const int GENRE_COUNT = (int)GENRE_NAMES.names.size();
 
 /**
  * Convert a genre to a string
@@ -29,25 +45,21 @@ const int GENRE_COUNT = (int)NONFICTION + 1;
  */
 string to_string(genre_data genre)
 {
-    switch (genre)
-    {
-    case FANTASY:
-        return "fantasy";
-    case SCIENCE_FICTION:
-        return "science fiction";
-    case MYSTERY:
-        return "mystery";
-    case ROMANCE:
-        return "romance";
-    case COOKING:
-        return "cooking";
-    case NONFICTION:
-        return "nonfiction";
-    default:
-        // While we expect the above, it can be broken
-        // when we cast from an integer...
-        return "unknown";
-    }
+    // Values cast from an integer may not be a genre, these are "unknown"
+    return string(enum_to_name(GENRE_NAMES, genre));
+}
+
+/**
+ * Convert a name, such as "science fiction", to a genre. Quick enough to
+ * use on every row when importing a catalog.
+ *
+ * @param name the name of the genre
+ * @param genre receives the genre, if the name is one
+ * @return true if the name is a genre
+ */
+bool to_genre(const string &name, genre_data &genre)
+{
+    return enum_from_name(GENRE_NAMES, name, genre);
 }
 
 /**
@@ -74,15 +86,22 @@ genre_data read_genre(string prompt)
 
     // Read in the integer value of the genre
     // - user enters 1 to GENRE_COUNT. So -1 needed.
-    // - provide a range if you can
+    // - only accept numbers that are a genre
     raw = read_integer(prompt) - 1;
+    while (!enum_from_int(GENRE_NAMES, raw, result))
+    {
+        write_line("Please enter a number from 1 to " + to_string(GENRE_COUNT));
+        raw = read_integer(prompt) - 1;
+    }
 
-    // Convert the raw integer data to a genre
-    return (genre_data)raw;
+    return result;
 }
 
-int main()
+int main(int argc, char *argv[])
 {
+    // Take --record <file> or --replay <file>
+    use_input_script(argc, argv);
+
     // Create a test_genre
     genre_data test_genre;
 
@@ -98,6 +117,12 @@ int main()
     // Output its name and integer value
     write_line(to_string(test_genre) + " has value " + to_string((int)test_genre));
 
+    // Look up a genre by its name
+    if (to_genre("romance", test_genre))
+    {
+        write_line("romance has value " + to_string((int)test_genre));
+    }
+
     // Read in genre data from the user
     test_genre = read_genre("Enter a genre: ");
 
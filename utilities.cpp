@@ -1,19 +1,28 @@
 #include "utilities.h"
+#include "number_parsing.h"
+#include "input_script.h"
 #include "splashkit.h"
+#include <cstdlib>
 
 string read_string(string prompt)
 {
-    write(prompt);
-    return read_line();
+    return read_input_line(prompt);
 }
 
 int read_integer(string prompt)
 {
-    string line = read_string(prompt);
-    while (!is_integer(line))
+    int value = 0;
+    parse_status status = parse_int(read_string(prompt), value);
+    while (status != PARSE_OK)
     {
-        write_line("Please enter a whole number.");
-        line = read_string(prompt);
+        // Piped or replayed input can run out before a number turns up
+        if (input_ended())
+        {
+            write_line("The input ended before a whole number was entered");
+            std::exit(1);
+        }
+        write_line(status == PARSE_OUT_OF_RANGE ? "Please enter a smaller number." : "Please enter a whole number.");
+        status = parse_int(read_string(prompt), value);
     }
-    return stoi(line);
+    return value;
 }
\ No newline at end of file